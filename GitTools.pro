@@ -5,15 +5,48 @@ CONFIG -= qt
 
 SOURCES += \
     src/BranchProtection.cpp \
+    src/DerivedURLs.cpp \
     src/GitTool.cpp \
+    src/HTTPClient.cpp \
+    src/IOExecutor.cpp \
+    src/Log.cpp \
+    src/OrgSnapshot.cpp \
+    src/Plan.cpp \
+    src/RateLimiter.cpp \
+    src/RecordWriter.cpp \
     src/Repository.cpp \
+    src/RepositoryFilter.cpp \
+    src/RepositoryTable.cpp \
+    src/RequestStats.cpp \
+    src/ResponseCache.cpp \
     src/Server.cpp \
+    src/StreamDecoder.cpp \
     src/Team.cpp \
-    src/User.cpp
+    src/Tracer.cpp \
+    src/User.cpp \
+    src/WorkerPool.cpp
 
 HEADERS += \
     src/BranchProtection.h \
+    src/DerivedURLs.h \
+    src/HTTPClient.h \
+    src/IOExecutor.h \
+    src/Log.h \
+    src/NameIndex.h \
+    src/OrgSnapshot.h \
+    src/PackedVector.h \
+    src/Paginated.h \
+    src/Plan.h \
+    src/RateLimiter.h \
+    src/RecordWriter.h \
     src/Repository.h \
+    src/RepositoryFilter.h \
+    src/RepositoryTable.h \
+    src/RequestStats.h \
+    src/ResponseCache.h \
     src/Server.h \
+    src/StreamDecoder.h \
     src/Team.h \
-    src/User.h
+    src/Tracer.h \
+    src/User.h \
+    src/WorkerPool.h
@@ -0,0 +1,124 @@
+//======================================================================
+// Compare decoding a page of repositories through a JSON DOM (the old way)
+// with streaming it straight into the objects (StreamDecoder), and with
+// streaming it into a PackedVector (PackedDecoder).
+//
+//     DecodeBench [iterations]
+//======================================================================
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "Repository.h"
+#include "StreamDecoder.h"
+
+using namespace GitTools;
+using std::cout;
+using std::endl;
+using std::string;
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * A page that looks like what GitHub sends for /orgs/X/repos?per_page=100.
+ */
+string makePage(int count) {
+    JSON page = JSON::array();
+
+    for (int index = 0; index < count; ++index) {
+        Repository repo;
+        string name = "repository-" + std::to_string(index);
+
+        repo.id = 100000 + index;
+        repo.nodeId = "MDEwOlJlcG9zaXRvcnkxMjk2MjY5" + std::to_string(index);
+        repo.name = name;
+        repo.fullName = "example-org/" + name;
+        repo.url = "https://api.github.com/repos/example-org/" + name;
+        repo.html_url = "https://github.com/example-org/" + name;
+        repo.description = "This is repository number " + std::to_string(index);
+        repo.homepage = "https://example.com";
+        repo.git_url = "git://github.com/example-org/" + name + ".git";
+        repo.ssh_url = "git@github.com:example-org/" + name + ".git";
+        repo.clone_url = repo.html_url + ".git";
+        repo.svn_url = repo.html_url;
+        repo.language = index % 3 == 0 ? "Go" : "C++";
+        repo.default_branch = "main";
+        repo.visibility = "private";
+        repo.isPrivate = true;
+        repo.pushed_at = "2024-01-01T00:00:00Z";
+        repo.created_at = "2020-01-01T00:00:00Z";
+        repo.updated_at = "2024-01-02T00:00:00Z";
+        repo.size = 1024 + index;
+        repo.has_issues = true;
+        repo.has_wiki = true;
+        repo.topics.add("example");
+        repo.topics.add("benchmark");
+
+        repo.owner.login = "example-org";
+        repo.owner.id = 42;
+        repo.owner.url = "https://api.github.com/users/example-org";
+        repo.owner.htmlURL = "https://github.com/example-org";
+        repo.owner.type = "Organization";
+
+        for (size_t which = 0; which < static_cast<size_t>(Repository::URLTemplate::Count); ++which) {
+            repo.setURLTemplate(static_cast<Repository::URLTemplate>(which), repo.url + Repository::urlTemplates[which].suffix);
+        }
+        page.push_back(repo.toJSON());
+    }
+
+    return page.dump();
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    const int itemCount = 100;
+    string body = makePage(itemCount);
+
+    // Make sure both ways agree before we time anything.
+    Repository::Vector domRepos;
+    domRepos.fromJSON(JSON::parse(body));
+    Repository::Vector saxRepos;
+    StreamDecoder<Repository>(saxRepos).parse(body);
+    Repository::Packed packedRepos;
+    PackedDecoder<Repository>(packedRepos).parse(body);
+    if (domRepos.size() != saxRepos.size() || domRepos.toJSON() != saxRepos.toJSON()
+        || domRepos.toJSON() != packedRepos.toJSON())
+    {
+        std::cerr << "DOM and streaming decodes disagree." << endl;
+        return 1;
+    }
+
+    auto report = [&](const string &label, Clock::duration elapsed) {
+        double perPage = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+        cout << label << ": " << perPage << " us/page, "
+             << perPage * 1000.0 / itemCount << " ns/item" << endl;
+    };
+
+    cout << "Page of " << itemCount << " repositories, " << body.size() << " bytes, "
+         << iterations << " iterations" << endl;
+
+    Clock::time_point start = Clock::now();
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        Repository::Vector vec;
+        JSON json = JSON::parse(body);
+        vec.fromJSON(json);
+    }
+    report("DOM      ", Clock::now() - start);
+
+    start = Clock::now();
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        Repository::Vector vec;
+        StreamDecoder<Repository>(vec).parse(body);
+    }
+    report("Streaming", Clock::now() - start);
+
+    start = Clock::now();
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        Repository::Packed packed;
+        PackedDecoder<Repository>(packed).parse(body);
+    }
+    report("Packed   ", Clock::now() - start);
+
+    return 0;
+}
@@ -0,0 +1,843 @@
+//======================================================================
+// A stand-in for api.github.com, so Server can be measured and exercised
+// without the network. Orgs are made up on request from their number, so
+// every run sees the same data:
+//
+//     MockGitHub --port 8080 --orgs 2 --repos 3000 --teams 40 --members 500
+//     GIT_HOST=http://localhost:8080 bin/GitTool --org org1 --repos
+//
+// The orgs are org1, org2, ... Each has --repos repos (repo-00000 on up),
+// --teams teams and --members members (user-00000 on up). /user/repos
+// lists org1's repos.
+//
+// It answers the listings with GitHub's paging and Link headers, single
+// repo and membership lookups, branches, branch protection (GET, PUT,
+// DELETE -- even-numbered repos' default branches start out protected),
+// collaborator PUTs and /rate_limit. Every GET response has an ETag, and
+// If-None-Match gets a 304 that, as on GitHub, doesn't count against the
+// rate limit.
+//
+// POST /graphql answers the org repositories query that
+// Server::forEachProtectedRepository sends, whatever the query text, with
+// each repo's protected branches as branchProtectionRules.
+//
+// --latency and --jitter slow each request down, --error-rate fails a
+// percentage of them with a 502, and --rate-limit sets the budget, which
+// refills every --reset seconds. --fail-page N always fails page N of a
+// listing, after a pause, for testing how a listing gives up part way.
+// --no-last-link leaves rel="last" out of the Link headers.
+//======================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <showlib/OptionHandler.h>
+#include <showlib/StringUtils.h>
+
+#include "Repository.h"
+#include "Team.h"
+#include "User.h"
+
+using namespace GitTools;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+/**
+ * What the command line controls.
+ */
+class Config {
+public:
+    int port = 8080;
+    int orgs = 1;
+    int repos = 300;
+    int teams = 20;
+    int members = 100;
+    int latencyMs = 0;
+    int jitterMs = 0;
+    double errorRate = 0.0;
+    int failPage = 0;
+    bool noLastLink = false;
+    int rateLimit = 5000;
+    int resetSeconds = 60;
+};
+
+/**
+ * One request as read off the socket. Header names are lower case.
+ */
+class Request {
+public:
+    string method;
+    string path;
+    std::map<string, string> query;
+    std::map<string, string> headers;
+    string body;
+
+    string header(const string &name) const {
+        auto it = headers.find(name);
+        return it != headers.end() ? it->second : string{};
+    }
+
+    int queryInt(const string &name, int defaultValue) const {
+        auto it = query.find(name);
+        return it != query.end() && !it->second.empty() ? atoi(it->second.c_str()) : defaultValue;
+    }
+};
+
+class Response {
+public:
+    int status = 200;
+    std::vector<std::pair<string, string>> headers;
+    string body;
+
+    Response() = default;
+    Response(int status, const JSON &json): status(status), body(json.dump()) {}
+
+    /** A {"message": ...} error, as GitHub sends. */
+    static Response message(int status, const string &text) {
+        JSON json = JSON::object();
+        json["message"] = text;
+        return Response(status, json);
+    }
+};
+
+/**
+ * The made-up GitHub.
+ */
+class MockGitHub {
+public:
+    MockGitHub(const Config &config);
+
+    void serve();
+
+protected:
+    void handleConnection(int fd);
+    bool readRequest(int fd, string &buffer, Request &request);
+    void writeResponse(int fd, const Request &request, Response &response);
+
+    Response route(const Request &request);
+    Response listing(const Request &request, const string &org, size_t count, const std::function<JSON(const string &, int)> &make);
+    Response protection(const Request &request, const string &org, int repoIndex, const string &branch);
+    Response graphQL(const Request &request);
+
+    int orgIndex(const string &org) const;
+    static int numberAfter(const string &name, const string &prefix);
+
+    JSON makeRepository(const string &org, int index) const;
+    JSON makeTeam(const string &org, int index) const;
+    JSON makeUser(const string &org, int index) const;
+    static string defaultBranch(int repoIndex);
+    JSON initialProtection(int repoIndex) const;
+    static JSON protectionFromUpdate(const JSON &update);
+    static JSON repositoryNode(const JSON &repo);
+    static JSON ruleFromProtection(const string &branch, const JSON &protection);
+
+    /** Take one request from the budget. False if it's spent. */
+    bool spendRateLimit();
+    void addRateLimitHeaders(Response &response);
+
+    Config config;
+
+    std::mutex rateMutex;
+    int remaining;
+    time_t resetAt;
+
+    /** Protection that's been PUT or DELETEd, by org/repo/branch. Null means deleted. */
+    std::mutex protectionMutex;
+    std::map<string, JSON> protections;
+
+    std::mutex randomMutex;
+    std::mt19937 generator;
+};
+
+MockGitHub::MockGitHub(const Config &config)
+    : config(config), remaining(config.rateLimit), resetAt(time(nullptr) + config.resetSeconds), generator(42)
+{
+}
+
+void MockGitHub::serve() {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(config.port));
+
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 128) != 0) {
+        perror("MockGitHub");
+        exit(1);
+    }
+
+    cerr << "Listening on http://127.0.0.1:" << config.port << " with " << config.orgs << " orgs of "
+         << config.repos << " repos, " << config.teams << " teams and " << config.members << " members." << endl;
+
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        std::thread([this, fd] { handleConnection(fd); }).detach();
+    }
+}
+
+/**
+ * Keep-alive: we serve requests on this connection until the client closes it.
+ */
+void MockGitHub::handleConnection(int fd) {
+    string buffer;
+    Request request;
+
+    while (readRequest(fd, buffer, request)) {
+        int delay = config.latencyMs;
+        bool fail = false;
+        if (config.jitterMs > 0 || config.errorRate > 0) {
+            std::lock_guard<std::mutex> lock(randomMutex);
+            delay += config.jitterMs > 0 ? static_cast<int>(generator() % static_cast<unsigned>(config.jitterMs + 1)) : 0;
+            fail = std::uniform_real_distribution<double>(0.0, 100.0)(generator) < config.errorRate;
+        }
+        if (delay > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        }
+
+        // The failing page is slow too, so the page workers are parked ahead of it when it fails.
+        if (config.failPage > 0 && request.method == "GET" && request.queryInt("page", 0) == config.failPage) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            fail = true;
+        }
+
+        Response response = fail ? Response::message(502, "Server Error") : route(request);
+        writeResponse(fd, request, response);
+
+        if (ShowLib::toLower(request.header("connection")) == "close") {
+            break;
+        }
+    }
+    close(fd);
+}
+
+bool MockGitHub::readRequest(int fd, string &buffer, Request &request) {
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == string::npos) {
+        char chunk[16384];
+        ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+        if (got <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(got));
+    }
+
+    request = Request();
+    std::istringstream head(buffer.substr(0, headerEnd));
+    string line;
+    string target;
+
+    std::getline(head, line);
+    std::istringstream(line) >> request.method >> target;
+
+    while (std::getline(head, line)) {
+        size_t colon = line.find(':');
+        if (colon != string::npos) {
+            request.headers[ShowLib::toLower(line.substr(0, colon))] = ShowLib::trim(line.substr(colon + 1));
+        }
+    }
+
+    size_t length = static_cast<size_t>(atol(request.header("content-length").c_str()));
+    size_t bodyStart = headerEnd + 4;
+    while (buffer.size() < bodyStart + length) {
+        char chunk[16384];
+        ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+        if (got <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(got));
+    }
+    request.body = buffer.substr(bodyStart, length);
+    buffer.erase(0, bodyStart + length);
+
+    size_t question = target.find('?');
+    request.path = target.substr(0, question);
+    if (question != string::npos) {
+        std::istringstream query(target.substr(question + 1));
+        string pair;
+        while (std::getline(query, pair, '&')) {
+            size_t equals = pair.find('=');
+            request.query[pair.substr(0, equals)] = equals != string::npos ? pair.substr(equals + 1) : string{};
+        }
+    }
+    return true;
+}
+
+/**
+ * Add the ETag and rate limit headers and send it. A matching If-None-Match
+ * turns a 200 into a 304, which is free.
+ */
+void MockGitHub::writeResponse(int fd, const Request &request, Response &response) {
+    bool counted = request.path != "/rate_limit";
+
+    if (response.status == 200 && request.method == "GET") {
+        char etag[32];
+        snprintf(etag, sizeof(etag), "\"%016zx\"", std::hash<string>{}(response.body));
+        if (request.header("if-none-match") == etag) {
+            response.status = 304;
+            response.body.clear();
+            counted = false;
+        }
+        response.headers.emplace_back("ETag", etag);
+    }
+
+    if (counted && !spendRateLimit()) {
+        response = Response::message(403, "API rate limit exceeded");
+    }
+    addRateLimitHeaders(response);
+
+    std::ostringstream out;
+    out << "HTTP/1.1 " << response.status << (response.status < 400 ? " OK" : " Error") << "\r\n"
+        << "Content-Type: application/json; charset=utf-8\r\n"
+        << "Content-Length: " << response.body.size() << "\r\n";
+    for (const auto & [name, value]: response.headers) {
+        out << name << ": " << value << "\r\n";
+    }
+    out << "\r\n" << response.body;
+
+    string data = out.str();
+    for (size_t sent = 0; sent < data.size(); ) {
+        ssize_t wrote = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (wrote <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(wrote);
+    }
+}
+
+bool MockGitHub::spendRateLimit() {
+    std::lock_guard<std::mutex> lock(rateMutex);
+    time_t now = time(nullptr);
+    if (now >= resetAt) {
+        remaining = config.rateLimit;
+        resetAt = now + config.resetSeconds;
+    }
+    if (remaining <= 0) {
+        return false;
+    }
+    --remaining;
+    return true;
+}
+
+void MockGitHub::addRateLimitHeaders(Response &response) {
+    std::lock_guard<std::mutex> lock(rateMutex);
+    response.headers.emplace_back("X-RateLimit-Limit", std::to_string(config.rateLimit));
+    response.headers.emplace_back("X-RateLimit-Remaining", std::to_string(remaining));
+    response.headers.emplace_back("X-RateLimit-Used", std::to_string(config.rateLimit - remaining));
+    response.headers.emplace_back("X-RateLimit-Reset", std::to_string(resetAt));
+    response.headers.emplace_back("X-RateLimit-Resource", "core");
+}
+
+//======================================================================
+// Routing.
+//======================================================================
+
+Response MockGitHub::route(const Request &request) {
+    std::vector<string> parts;
+    std::istringstream path(request.path);
+    for (string part; std::getline(path, part, '/'); ) {
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+    }
+
+    const string &method = request.method;
+    size_t n = parts.size();
+
+    if (n == 1 && parts[0] == "rate_limit") {
+        JSON core = JSON::object();
+        std::lock_guard<std::mutex> lock(rateMutex);
+        core["limit"] = config.rateLimit;
+        core["remaining"] = remaining;
+        core["used"] = config.rateLimit - remaining;
+        core["reset"] = resetAt;
+        JSON json = JSON::object();
+        json["resources"]["core"] = core;
+        json["rate"] = core;
+        return Response(200, json);
+    }
+
+    if (n == 1 && parts[0] == "graphql" && method == "POST") {
+        return graphQL(request);
+    }
+
+    if (n == 2 && parts[0] == "user" && parts[1] == "repos" && method == "GET") {
+        return listing(request, "org1", static_cast<size_t>(config.repos), [this](const string &org, int i) { return makeRepository(org, i); });
+    }
+
+    if (n >= 3 && parts[0] == "orgs" && method == "GET") {
+        const string &org = parts[1];
+        if (orgIndex(org) < 0) {
+            return Response::message(404, "Not Found");
+        }
+        if (n == 3 && parts[2] == "repos") {
+            return listing(request, org, static_cast<size_t>(config.repos), [this](const string &o, int i) { return makeRepository(o, i); });
+        }
+        if (n == 3 && parts[2] == "teams") {
+            return listing(request, org, static_cast<size_t>(config.teams), [this](const string &o, int i) { return makeTeam(o, i); });
+        }
+        if (n == 3 && parts[2] == "members") {
+            return listing(request, org, static_cast<size_t>(config.members), [this](const string &o, int i) { return makeUser(o, i); });
+        }
+        if (n == 4 && parts[2] == "members") {
+            int index = numberAfter(parts[3], "user-");
+            Response response;
+            response.status = index >= 0 && index < config.members ? 204 : 404;
+            return response;
+        }
+    }
+
+    if (n >= 3 && parts[0] == "repos") {
+        const string &org = parts[1];
+        int index = numberAfter(parts[2], "repo-");
+        if (orgIndex(org) < 0 || index < 0 || index >= config.repos) {
+            return Response::message(404, "Not Found");
+        }
+
+        if (n == 3 && method == "GET") {
+            return Response(200, makeRepository(org, index));
+        }
+        if (n == 4 && parts[3] == "branches" && method == "GET") {
+            const string names[] = { defaultBranch(index), "develop" };
+            return listing(request, org, 2, [&](const string &, int branchIndex) {
+                JSON branch = JSON::object();
+                branch["name"] = names[branchIndex];
+                branch["protected"] = false;
+                return branch;
+            });
+        }
+        if (n == 6 && parts[3] == "branches" && parts[5] == "protection") {
+            return protection(request, org, index, parts[4]);
+        }
+        if (n == 5 && parts[3] == "collaborators" && method == "PUT") {
+            return numberAfter(parts[4], "user-") >= 0 ? Response(201, JSON::object()) : Response::message(404, "Not Found");
+        }
+    }
+
+    if (n == 1 && parts[0] == "user") {
+        JSON json = JSON::object();
+        json["login"] = "mock";
+        return Response(200, json);
+    }
+
+    return Response::message(404, "Not Found");
+}
+
+/**
+ * One page of a listing, with GitHub's Link header. --no-last-link leaves out
+ * rel="last", as GitHub does for some listings.
+ */
+Response MockGitHub::listing(const Request &request, const string &org, size_t count, const std::function<JSON(const string &, int)> &make) {
+    int perPage = std::min(std::max(request.queryInt("per_page", 30), 1), 100);
+    int page = std::max(request.queryInt("page", 1), 1);
+    size_t lastPage = std::max<size_t>((count + perPage - 1) / perPage, 1);
+
+    JSON json = JSON::array();
+    for (size_t index = static_cast<size_t>(page - 1) * perPage; index < count && index < static_cast<size_t>(page) * perPage; ++index) {
+        json.push_back(make(org, static_cast<int>(index)));
+    }
+
+    Response response(200, json);
+
+    string base = "http://" + request.header("host") + request.path + "?";
+    for (const auto & [key, value]: request.query) {
+        if (key != "page") {
+            base += key + "=" + value + "&";
+        }
+    }
+    base += "page=";
+
+    std::vector<string> links;
+    if (static_cast<size_t>(page) < lastPage) {
+        links.push_back("<" + base + std::to_string(page + 1) + ">; rel=\"next\"");
+        if (!config.noLastLink) {
+            links.push_back("<" + base + std::to_string(lastPage) + ">; rel=\"last\"");
+        }
+    }
+    if (page > 1) {
+        links.push_back("<" + base + "1>; rel=\"first\"");
+        links.push_back("<" + base + std::to_string(page - 1) + ">; rel=\"prev\"");
+    }
+    if (!links.empty()) {
+        string link = links[0];
+        for (size_t index = 1; index < links.size(); ++index) {
+            link += ", " + links[index];
+        }
+        response.headers.emplace_back("Link", link);
+    }
+
+    return response;
+}
+
+Response MockGitHub::protection(const Request &request, const string &org, int repoIndex, const string &branch) {
+    string key = org + "/" + std::to_string(repoIndex) + "/" + branch;
+    std::lock_guard<std::mutex> lock(protectionMutex);
+
+    if (request.method == "PUT") {
+        JSON update = JSON::parse(request.body, nullptr, false);
+        if (!update.is_object()) {
+            return Response::message(400, "Problems parsing JSON");
+        }
+        protections[key] = protectionFromUpdate(update);
+        return Response(200, protections[key]);
+    }
+
+    auto it = protections.find(key);
+    JSON current = it != protections.end() ? it->second
+        : branch == defaultBranch(repoIndex) ? initialProtection(repoIndex) : JSON();
+
+    if (request.method == "DELETE") {
+        if (current.is_null()) {
+            return Response::message(404, "Branch not protected");
+        }
+        protections[key] = nullptr;
+        Response response;
+        response.status = 204;
+        return response;
+    }
+
+    if (current.is_null()) {
+        return Response::message(404, "Branch not protected");
+    }
+    return Response(200, current);
+}
+
+/**
+ * One page of an org's repos, 100 at a time, with their protection as rules. The
+ * cursor is the index of the next repo. Like GitHub, an unknown org is a 200 with
+ * errors and a null organization.
+ */
+Response MockGitHub::graphQL(const Request &request) {
+    JSON body = JSON::parse(request.body, nullptr, false);
+    if (!body.is_object()) {
+        return Response::message(400, "Problems parsing JSON");
+    }
+
+    JSON variables = ShowLib::JSONSerializable::jsonValue(body, "variables");
+    string org = ShowLib::JSONSerializable::stringValue(variables, "org");
+    string cursor = ShowLib::JSONSerializable::stringValue(variables, "cursor");
+
+    if (orgIndex(org) < 0) {
+        JSON error = JSON::object();
+        error["type"] = "NOT_FOUND";
+        error["path"] = JSON::array({ "organization" });
+        error["message"] = "Could not resolve to an Organization with the login of '" + org + "'.";
+
+        JSON json = JSON::object();
+        json["data"]["organization"] = nullptr;
+        json["errors"] = JSON::array({ error });
+        return Response(200, json);
+    }
+
+    int first = cursor.empty() ? 0 : std::max(atoi(cursor.c_str()), 0);
+    int last = std::min(first + 100, config.repos);
+
+    JSON nodes = JSON::array();
+    std::lock_guard<std::mutex> lock(protectionMutex);
+    for (int index = first; index < last; ++index) {
+        JSON node = repositoryNode(makeRepository(org, index));
+
+        // Each branch's current protection: the default branch's starting point,
+        // then whatever has been PUT or DELETEd since.
+        std::map<string, JSON> current;
+        current[defaultBranch(index)] = initialProtection(index);
+        string prefix = org + "/" + std::to_string(index) + "/";
+        for (auto it = protections.lower_bound(prefix); it != protections.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            current[it->first.substr(prefix.size())] = it->second;
+        }
+
+        JSON rules = JSON::array();
+        for (const auto & [branch, protection]: current) {
+            if (!protection.is_null()) {
+                rules.push_back(ruleFromProtection(branch, protection));
+            }
+        }
+        node["branchProtectionRules"]["nodes"] = rules;
+        nodes.push_back(node);
+    }
+
+    JSON repositories = JSON::object();
+    repositories["pageInfo"]["hasNextPage"] = last < config.repos;
+    repositories["pageInfo"]["endCursor"] = std::to_string(last);
+    repositories["nodes"] = nodes;
+
+    JSON json = JSON::object();
+    json["data"]["organization"]["repositories"] = repositories;
+    return Response(200, json);
+}
+
+//======================================================================
+// Made-up data.
+//======================================================================
+
+/**
+ * org3 is 2; anything else is -1.
+ */
+int MockGitHub::orgIndex(const string &org) const {
+    int index = numberAfter(org, "org") - 1;
+    return index >= 0 && index < config.orgs ? index : -1;
+}
+
+/**
+ * "repo-00042" with prefix "repo-" is 42. -1 if it isn't prefix and a number.
+ */
+int MockGitHub::numberAfter(const string &name, const string &prefix) {
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) {
+        return -1;
+    }
+    for (size_t index = prefix.size(); index < name.size(); ++index) {
+        if (!isdigit(static_cast<unsigned char>(name[index]))) {
+            return -1;
+        }
+    }
+    return atoi(name.c_str() + prefix.size());
+}
+
+/**
+ * Names sort in index order and updated_at goes down with the index, so the
+ * listing order is right for both the default sort and sort=updated.
+ */
+JSON MockGitHub::makeRepository(const string &org, int index) const {
+    static const char * languages[] = { "Go", "C++", "Python", "TypeScript", "Java", "" };
+    char name[32];
+    snprintf(name, sizeof(name), "repo-%05d", index);
+
+    char updated[32];
+    time_t when = 1700000000 - static_cast<time_t>(index) * 3600;
+    strftime(updated, sizeof(updated), "%Y-%m-%dT%H:%M:%SZ", gmtime(&when));
+
+    Repository repo;
+    repo.id = (orgIndex(org) + 1) * 1000000 + index;
+    repo.name = name;
+    repo.fullName = org + "/" + name;
+    repo.url = "https://api.github.com/repos/" + repo.fullName;
+    repo.html_url = "https://github.com/" + repo.fullName;
+    repo.description = "Made-up repository number " + std::to_string(index);
+    repo.clone_url = repo.html_url + ".git";
+    repo.ssh_url = "git@github.com:" + repo.fullName + ".git";
+    repo.language = languages[index % 6];
+    repo.default_branch = defaultBranch(index);
+    repo.isPrivate = index % 3 != 0;
+    repo.visibility = repo.isPrivate ? "private" : "public";
+    repo.archived = index % 10 == 9;
+    repo.fork = index % 17 == 5;
+    repo.created_at = "2020-01-01T00:00:00Z";
+    repo.updated_at = updated;
+    repo.pushed_at = updated;
+    repo.size = 100 + index % 5000;
+    repo.stargazers_count = index % 50;
+    repo.watchers_count = repo.stargazers_count;
+    repo.forks_count = index % 7;
+    repo.open_issues_count = index % 11;
+    repo.has_issues = true;
+    repo.has_wiki = index % 2 == 0;
+    repo.topics.add("mock");
+
+    repo.owner.login = org;
+    repo.owner.id = orgIndex(org) + 1;
+    repo.owner.type = "Organization";
+
+    return repo.toJSON();
+}
+
+JSON MockGitHub::makeTeam(const string &org, int index) const {
+    Team team;
+    team.id = (orgIndex(org) + 1) * 1000000 + index;
+    team.name = "Team " + std::to_string(index);
+    team.slug = "team-" + std::to_string(index);
+    team.privacy = "closed";
+    team.permission = "pull";
+    team.url = "https://api.github.com/orgs/" + org + "/teams/" + team.slug;
+    team.members_url = team.url + "/members{/member}";
+    team.repositories_url = team.url + "/repos";
+    return team.toJSON();
+}
+
+JSON MockGitHub::makeUser(const string &, int index) const {
+    char login[32];
+    snprintf(login, sizeof(login), "user-%05d", index);
+
+    User user{};
+    user.id = 5000000 + index;
+    user.login = login;
+    user.type = "User";
+    user.url = string{"https://api.github.com/users/"} + login;
+    user.html_url = string{"https://github.com/"} + login;
+    user.avatar_url = "https://avatars.githubusercontent.com/u/" + std::to_string(user.id);
+    return user.toJSON();
+}
+
+string MockGitHub::defaultBranch(int repoIndex) {
+    return repoIndex % 4 == 0 ? "master" : "main";
+}
+
+/**
+ * Even repos' default branches start out protected: reviews required, admins included.
+ */
+JSON MockGitHub::initialProtection(int repoIndex) const {
+    if (repoIndex % 2 != 0) {
+        return nullptr;
+    }
+    JSON update = JSON::object();
+    update["enforce_admins"] = true;
+    update["required_pull_request_reviews"]["required_approving_review_count"] = 1;
+    update["required_pull_request_reviews"]["dismiss_stale_reviews"] = true;
+    update["required_status_checks"]["strict"] = true;
+    update["required_status_checks"]["contexts"] = JSON::array({ "ci" });
+    update["allow_force_pushes"] = false;
+    update["allow_deletions"] = false;
+    return protectionFromUpdate(update);
+}
+
+/**
+ * Turn a PUT body into what a GET then returns, where the flags become {"enabled": x}
+ * and unset sections are left out.
+ */
+JSON MockGitHub::protectionFromUpdate(const JSON &update) {
+    JSON json = JSON::object();
+    for (auto it = update.begin(); it != update.end(); ++it) {
+        if (it.value().is_null()) {
+            continue;
+        }
+        if (it.value().is_boolean()) {
+            json[it.key()]["enabled"] = it.value();
+        }
+        else {
+            json[it.key()] = it.value();
+        }
+    }
+    return json;
+}
+
+/**
+ * A REST repo as GraphQL's Repository, with the fields the protection query asks for.
+ */
+JSON MockGitHub::repositoryNode(const JSON &repo) {
+    using ShowLib::JSONSerializable;
+
+    JSON node = JSON::object();
+    node["databaseId"] = JSONSerializable::intValue(repo, "id");
+    node["id"] = JSONSerializable::stringValue(repo, "node_id");
+    node["name"] = JSONSerializable::stringValue(repo, "name");
+    node["nameWithOwner"] = JSONSerializable::stringValue(repo, "full_name");
+    node["url"] = JSONSerializable::stringValue(repo, "html_url");
+    node["description"] = JSONSerializable::stringValue(repo, "description");
+    node["homepageUrl"] = JSONSerializable::stringValue(repo, "homepage");
+    node["isArchived"] = JSONSerializable::boolValue(repo, "archived");
+    node["isDisabled"] = JSONSerializable::boolValue(repo, "disabled");
+    node["isFork"] = JSONSerializable::boolValue(repo, "fork");
+    node["isPrivate"] = JSONSerializable::boolValue(repo, "private");
+    node["isTemplate"] = JSONSerializable::boolValue(repo, "is_template");
+    string visibility = JSONSerializable::stringValue(repo, "visibility");
+    std::transform(visibility.begin(), visibility.end(), visibility.begin(), [](unsigned char c) { return static_cast<char>(toupper(c)); });
+    node["visibility"] = visibility;
+    node["hasIssuesEnabled"] = JSONSerializable::boolValue(repo, "has_issues");
+    node["hasProjectsEnabled"] = JSONSerializable::boolValue(repo, "has_projects");
+    node["hasWikiEnabled"] = JSONSerializable::boolValue(repo, "has_wiki");
+    node["pushedAt"] = JSONSerializable::stringValue(repo, "pushed_at");
+    node["createdAt"] = JSONSerializable::stringValue(repo, "created_at");
+    node["updatedAt"] = JSONSerializable::stringValue(repo, "updated_at");
+    node["diskUsage"] = JSONSerializable::intValue(repo, "size");
+    node["forkCount"] = JSONSerializable::intValue(repo, "forks_count");
+    node["stargazerCount"] = JSONSerializable::intValue(repo, "stargazers_count");
+    node["issues"]["totalCount"] = JSONSerializable::intValue(repo, "open_issues_count");
+    node["pullRequests"]["totalCount"] = 0;
+
+    JSON owner = JSONSerializable::jsonValue(repo, "owner");
+    node["owner"]["__typename"] = JSONSerializable::stringValue(owner, "type");
+    node["owner"]["login"] = JSONSerializable::stringValue(owner, "login");
+    node["owner"]["databaseId"] = JSONSerializable::intValue(owner, "id");
+    node["owner"]["url"] = "https://github.com/" + JSONSerializable::stringValue(owner, "login");
+
+    string language = JSONSerializable::stringValue(repo, "language");
+    node["primaryLanguage"] = language.empty() ? JSON() : JSON::object({ { "name", language } });
+    node["defaultBranchRef"]["name"] = JSONSerializable::stringValue(repo, "default_branch");
+    return node;
+}
+
+/**
+ * A branch's REST protection as a GraphQL BranchProtectionRule for just that branch.
+ */
+JSON MockGitHub::ruleFromProtection(const string &branch, const JSON &protection) {
+    using ShowLib::JSONSerializable;
+
+    auto flag = [&](const char *key) {
+        return JSONSerializable::boolValue(JSONSerializable::jsonValue(protection, key), "enabled");
+    };
+    JSON reviews = JSONSerializable::jsonValue(protection, "required_pull_request_reviews");
+    JSON checks = JSONSerializable::jsonValue(protection, "required_status_checks");
+
+    JSON rule = JSON::object();
+    rule["pattern"] = branch;
+    rule["isAdminEnforced"] = flag("enforce_admins");
+    rule["allowsDeletions"] = flag("allow_deletions");
+    rule["allowsForcePushes"] = flag("allow_force_pushes");
+    rule["blocksCreations"] = flag("block_creations");
+    rule["lockBranch"] = flag("lock_branch");
+    rule["lockAllowsFetchAndMerge"] = flag("allow_fork_syncing");
+    rule["requiresLinearHistory"] = flag("required_linear_history");
+    rule["requiresConversationResolution"] = flag("required_conversation_resolution");
+    rule["requiresCommitSignatures"] = flag("required_signatures");
+    rule["restrictsPushes"] = protection.contains("restrictions");
+
+    rule["requiresApprovingReviews"] = reviews.is_object();
+    rule["requiredApprovingReviewCount"] = JSONSerializable::intValue(reviews, "required_approving_review_count");
+    rule["dismissesStaleReviews"] = JSONSerializable::boolValue(reviews, "dismiss_stale_reviews");
+    rule["requiresCodeOwnerReviews"] = JSONSerializable::boolValue(reviews, "require_code_owner_reviews");
+    rule["requireLastPushApproval"] = JSONSerializable::boolValue(reviews, "require_last_push_approval");
+
+    rule["requiresStatusChecks"] = checks.is_object();
+    rule["requiresStrictStatusChecks"] = JSONSerializable::boolValue(checks, "strict");
+    rule["requiredStatusCheckContexts"] = JSONSerializable::jsonArray(checks, "contexts");
+    return rule;
+}
+
+int main(int argc, char **argv) {
+    Config config;
+    ShowLib::OptionHandler::ArgumentVector args;
+
+    args.addArg("port",       [&](const char *value){ config.port = atoi(value); },         "8080", "Listen on this port (on 127.0.0.1)");
+    args.addArg("orgs",       [&](const char *value){ config.orgs = atoi(value); },         "1",    "How many orgs: org1, org2, ...");
+    args.addArg("repos",      [&](const char *value){ config.repos = atoi(value); },        "300",  "Repos per org");
+    args.addArg("teams",      [&](const char *value){ config.teams = atoi(value); },        "20",   "Teams per org");
+    args.addArg("members",    [&](const char *value){ config.members = atoi(value); },      "100",  "Members per org");
+    args.addArg("latency",    [&](const char *value){ config.latencyMs = atoi(value); },    "0",    "Milliseconds to wait before each response");
+    args.addArg("jitter",     [&](const char *value){ config.jitterMs = atoi(value); },     "0",    "Up to this many more milliseconds, at random");
+    args.addArg("error-rate", [&](const char *value){ config.errorRate = atof(value); },    "0",    "Percentage of requests that fail with a 502");
+    args.addArg("fail-page",  [&](const char *value){ config.failPage = atoi(value); },     "0",    "Half a second late, fail this page of every listing with a 502");
+    args.addNoArg("no-last-link", [&](const char *){ config.noLastLink = true; },                   "Leave rel=\"last\" out of the Link headers, so clients have to find the end");
+    args.addArg("rate-limit", [&](const char *value){ config.rateLimit = atoi(value); },    "5000", "Requests allowed per window");
+    args.addArg("reset",      [&](const char *value){ config.resetSeconds = atoi(value); }, "60",   "Seconds in a rate limit window");
+
+    if (!ShowLib::OptionHandler::handleOptions(argc, argv, args)) {
+        exit(0);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    MockGitHub(config).serve();
+}
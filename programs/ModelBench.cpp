@@ -0,0 +1,335 @@
+//======================================================================
+// Time the models' JSON paths -- fromJSON, the streaming decoder and
+// toJSON -- for Repository, Team, User and BranchProtection, over one
+// object, a 100-item page and a 10,000-item set.
+//
+//     ModelBench [scale]
+//
+// For each we report ns/object, heap allocations per object and the heap
+// bytes per object still held by the result. scale multiplies the number
+// of iterations.
+//
+// The payloads are shaped like GitHub's (a complete repository object as
+// /orgs/X/repos returns it, and so on), copied with a different name and
+// id for each item.
+//======================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+#include "BranchProtection.h"
+#include "Repository.h"
+#include "StreamDecoder.h"
+#include "Team.h"
+#include "User.h"
+
+using namespace GitTools;
+using std::cout;
+using std::endl;
+using std::string;
+
+typedef std::chrono::steady_clock Clock;
+
+//======================================================================
+// Count every allocation, and the bytes currently allocated.
+//======================================================================
+static std::atomic<size_t> allocationCount{0};
+static std::atomic<long> liveBytes{0};
+
+void * operator new(size_t size) {
+    void *ptr = malloc(size > 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    liveBytes.fetch_add(static_cast<long>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    if (ptr != nullptr) {
+        liveBytes.fetch_sub(static_cast<long>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+        free(ptr);
+    }
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+//======================================================================
+// Sample payloads.
+//======================================================================
+static const char * repositorySample = R"({
+    "id": 1296269, "node_id": "MDEwOlJlcG9zaXRvcnkxMjk2MjY5", "name": "Hello-World", "full_name": "octocat/Hello-World",
+    "owner": {
+        "login": "octocat", "id": 1, "node_id": "MDQ6VXNlcjE=", "avatar_url": "https://github.com/images/error/octocat_happy.gif",
+        "gravatar_id": "", "url": "https://api.github.com/users/octocat", "html_url": "https://github.com/octocat",
+        "followers_url": "https://api.github.com/users/octocat/followers",
+        "following_url": "https://api.github.com/users/octocat/following{/other_user}",
+        "gists_url": "https://api.github.com/users/octocat/gists{/gist_id}",
+        "starred_url": "https://api.github.com/users/octocat/starred{/owner}{/repo}",
+        "subscriptions_url": "https://api.github.com/users/octocat/subscriptions",
+        "organizations_url": "https://api.github.com/users/octocat/orgs", "repos_url": "https://api.github.com/users/octocat/repos",
+        "events_url": "https://api.github.com/users/octocat/events{/privacy}",
+        "received_events_url": "https://api.github.com/users/octocat/received_events", "type": "User", "site_admin": false
+    },
+    "private": false, "html_url": "https://github.com/octocat/Hello-World", "description": "This your first repo!", "fork": false,
+    "url": "https://api.github.com/repos/octocat/Hello-World",
+    "archive_url": "https://api.github.com/repos/octocat/Hello-World/{archive_format}{/ref}",
+    "assignees_url": "https://api.github.com/repos/octocat/Hello-World/assignees{/user}",
+    "blobs_url": "https://api.github.com/repos/octocat/Hello-World/git/blobs{/sha}",
+    "branches_url": "https://api.github.com/repos/octocat/Hello-World/branches{/branch}",
+    "collaborators_url": "https://api.github.com/repos/octocat/Hello-World/collaborators{/collaborator}",
+    "comments_url": "https://api.github.com/repos/octocat/Hello-World/comments{/number}",
+    "commits_url": "https://api.github.com/repos/octocat/Hello-World/commits{/sha}",
+    "compare_url": "https://api.github.com/repos/octocat/Hello-World/compare/{base}...{head}",
+    "contents_url": "https://api.github.com/repos/octocat/Hello-World/contents/{+path}",
+    "contributors_url": "https://api.github.com/repos/octocat/Hello-World/contributors",
+    "deployments_url": "https://api.github.com/repos/octocat/Hello-World/deployments",
+    "downloads_url": "https://api.github.com/repos/octocat/Hello-World/downloads",
+    "events_url": "https://api.github.com/repos/octocat/Hello-World/events",
+    "forks_url": "https://api.github.com/repos/octocat/Hello-World/forks",
+    "git_commits_url": "https://api.github.com/repos/octocat/Hello-World/git/commits{/sha}",
+    "git_refs_url": "https://api.github.com/repos/octocat/Hello-World/git/refs{/sha}",
+    "git_tags_url": "https://api.github.com/repos/octocat/Hello-World/git/tags{/sha}",
+    "git_url": "git:github.com/octocat/Hello-World.git",
+    "issue_comment_url": "https://api.github.com/repos/octocat/Hello-World/issues/comments{/number}",
+    "issue_events_url": "https://api.github.com/repos/octocat/Hello-World/issues/events{/number}",
+    "issues_url": "https://api.github.com/repos/octocat/Hello-World/issues{/number}",
+    "keys_url": "https://api.github.com/repos/octocat/Hello-World/keys{/key_id}",
+    "labels_url": "https://api.github.com/repos/octocat/Hello-World/labels{/name}",
+    "languages_url": "https://api.github.com/repos/octocat/Hello-World/languages",
+    "merges_url": "https://api.github.com/repos/octocat/Hello-World/merges",
+    "milestones_url": "https://api.github.com/repos/octocat/Hello-World/milestones{/number}",
+    "notifications_url": "https://api.github.com/repos/octocat/Hello-World/notifications{?since,all,participating}",
+    "pulls_url": "https://api.github.com/repos/octocat/Hello-World/pulls{/number}",
+    "releases_url": "https://api.github.com/repos/octocat/Hello-World/releases{/id}",
+    "ssh_url": "git@github.com:octocat/Hello-World.git",
+    "stargazers_url": "https://api.github.com/repos/octocat/Hello-World/stargazers",
+    "statuses_url": "https://api.github.com/repos/octocat/Hello-World/statuses/{sha}",
+    "subscribers_url": "https://api.github.com/repos/octocat/Hello-World/subscribers",
+    "subscription_url": "https://api.github.com/repos/octocat/Hello-World/subscription",
+    "tags_url": "https://api.github.com/repos/octocat/Hello-World/tags",
+    "teams_url": "https://api.github.com/repos/octocat/Hello-World/teams",
+    "trees_url": "https://api.github.com/repos/octocat/Hello-World/git/trees{/sha}",
+    "clone_url": "https://github.com/octocat/Hello-World.git", "mirror_url": "git:git.example.com/octocat/Hello-World",
+    "hooks_url": "https://api.github.com/repos/octocat/Hello-World/hooks", "svn_url": "https://svn.github.com/octocat/Hello-World",
+    "homepage": "https://github.com", "language": null, "forks_count": 9, "stargazers_count": 80, "watchers_count": 80,
+    "size": 108, "default_branch": "master", "open_issues_count": 0, "is_template": false,
+    "topics": ["octocat", "atom", "electron", "api"],
+    "has_issues": true, "has_projects": true, "has_wiki": true, "has_pages": false, "has_downloads": true,
+    "has_discussions": false, "archived": false, "disabled": false, "visibility": "public",
+    "pushed_at": "2011-01-26T19:06:43Z", "created_at": "2011-01-26T19:01:12Z", "updated_at": "2011-01-26T19:14:43Z",
+    "permissions": { "admin": false, "push": false, "pull": true },
+    "security_and_analysis": {
+        "advanced_security": { "status": "enabled" }, "secret_scanning": { "status": "enabled" },
+        "secret_scanning_push_protection": { "status": "disabled" }
+    }
+})";
+
+static const char * teamSample = R"({
+    "id": 1, "node_id": "MDQ6VGVhbTE=", "url": "https://api.github.com/teams/1",
+    "html_url": "https://github.com/orgs/github/teams/justice-league", "name": "Justice League", "slug": "justice-league",
+    "description": "A great team.", "privacy": "closed", "notification_setting": "notifications_enabled",
+    "permission": "admin", "members_url": "https://api.github.com/teams/1/members{/member}",
+    "repositories_url": "https://api.github.com/teams/1/repos", "parent": null
+})";
+
+static const char * userSample = R"({
+    "login": "octocat", "id": 1, "node_id": "MDQ6VXNlcjE=", "avatar_url": "https://github.com/images/error/octocat_happy.gif",
+    "gravatar_id": "", "url": "https://api.github.com/users/octocat", "html_url": "https://github.com/octocat",
+    "followers_url": "https://api.github.com/users/octocat/followers",
+    "following_url": "https://api.github.com/users/octocat/following{/other_user}",
+    "gists_url": "https://api.github.com/users/octocat/gists{/gist_id}",
+    "starred_url": "https://api.github.com/users/octocat/starred{/owner}{/repo}",
+    "subscriptions_url": "https://api.github.com/users/octocat/subscriptions",
+    "organizations_url": "https://api.github.com/users/octocat/orgs", "repos_url": "https://api.github.com/users/octocat/repos",
+    "events_url": "https://api.github.com/users/octocat/events{/privacy}",
+    "received_events_url": "https://api.github.com/users/octocat/received_events", "type": "User", "site_admin": false
+})";
+
+static const char * protectionSample = R"({
+    "url": "https://api.github.com/repos/octocat/Hello-World/branches/master/protection",
+    "required_status_checks": {
+        "url": "https://api.github.com/repos/octocat/Hello-World/branches/master/protection/required_status_checks",
+        "contexts": ["continuous-integration/travis-ci"],
+        "contexts_url": "https://api.github.com/repos/octocat/Hello-World/branches/master/protection/required_status_checks/contexts",
+        "enforcement_level": "non_admins", "strict": true,
+        "checks": [ { "context": "continuous-integration/travis-ci", "app_id": null } ]
+    },
+    "enforce_admins": { "url": "https://api.github.com/repos/octocat/Hello-World/branches/master/protection/enforce_admins", "enabled": true },
+    "required_pull_request_reviews": {
+        "url": "https://api.github.com/repos/octocat/Hello-World/branches/master/protection/required_pull_request_reviews",
+        "dismissal_restrictions": {
+            "url": "https://api.github.com/repos/octocat/Hello-World/branches/master/protection/dismissal_restrictions",
+            "users_url": "https://api.github.com/repos/octocat/Hello-World/branches/master/protection/dismissal_restrictions/users",
+            "teams_url": "https://api.github.com/repos/octocat/Hello-World/branches/master/protection/dismissal_restrictions/teams",
+            "users": [], "teams": [], "apps": []
+        },
+        "dismiss_stale_reviews": true, "require_code_owner_reviews": true, "required_approving_review_count": 2,
+        "require_last_push_approval": true
+    },
+    "required_signatures": {
+        "url": "https://api.github.com/repos/octocat/Hello-World/branches/master/protection/required_signatures", "enabled": false
+    },
+    "required_linear_history": { "enabled": true }, "allow_force_pushes": { "enabled": false },
+    "allow_deletions": { "enabled": false }, "block_creations": { "enabled": true },
+    "required_conversation_resolution": { "enabled": true }, "lock_branch": { "enabled": false },
+    "allow_fork_syncing": { "enabled": true }
+})";
+
+/**
+ * An array of count copies of sample, each with its own id and name.
+ */
+static string makePayload(const char *sample, const char *nameKey, size_t count) {
+    JSON prototype = JSON::parse(sample);
+    JSON array = JSON::array();
+
+    for (size_t index = 0; index < count; ++index) {
+        JSON item = prototype;
+        if (item.contains("id")) {
+            item["id"] = 1000000 + index;
+        }
+        if (nameKey != nullptr) {
+            item[nameKey] = item[nameKey].get<string>() + "-" + std::to_string(index);
+        }
+        array.push_back(std::move(item));
+    }
+    return array.dump();
+}
+
+//======================================================================
+// Measuring.
+//======================================================================
+
+/**
+ * One line of the report. run() does the work once and returns something that
+ * keeps its result alive, so we can see how much memory the result holds.
+ */
+template <class Result>
+static void measure(const string &label, size_t objects, int iterations, const std::function<Result()> &run) {
+    // Once to build any lookup tables, which would otherwise count as retained,
+    // and once more to see what the result holds on to.
+    run();
+    long before = liveBytes.load();
+    size_t retained = 0;
+    {
+        Result held = run();
+        retained = static_cast<size_t>(std::max(liveBytes.load() - before, 0L));
+    }
+
+    size_t allocationsBefore = allocationCount.load();
+    Clock::time_point start = Clock::now();
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        Result result = run();
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    size_t allocations = allocationCount.load() - allocationsBefore;
+
+    double total = static_cast<double>(objects) * iterations;
+    cout << std::left << std::setw(36) << label << std::right << std::fixed
+         << std::setw(8) << objects
+         << std::setw(12) << std::setprecision(0) << elapsed / total
+         << std::setw(12) << std::setprecision(1) << allocations / total
+         << std::setw(12) << std::setprecision(0) << retained / static_cast<double>(objects)
+         << endl;
+}
+
+/** Enough iterations that each line handles about this many objects. */
+static int iterationsFor(size_t objects, int scale) {
+    return std::max(static_cast<int>(20000 / objects), 3) * scale;
+}
+
+/**
+ * fromJSON, streaming and toJSON for one of the listing models.
+ */
+template <class T>
+static void benchListing(const string &name, const char *sample, const char *nameKey, size_t count, int scale) {
+    string body = makePayload(sample, nameKey, count);
+    int iterations = iterationsFor(count, scale);
+
+    measure<std::shared_ptr<typename T::Vector>>(name + " fromJSON", count, iterations, [&]() {
+        auto vec = std::make_shared<typename T::Vector>();
+        vec->fromJSON(JSON::parse(body));
+        return vec;
+    });
+
+    measure<std::shared_ptr<typename T::Vector>>(name + " streaming", count, iterations, [&]() {
+        auto vec = std::make_shared<typename T::Vector>();
+        StreamDecoder<T>(*vec).parse(body);
+        return vec;
+    });
+
+    typename T::Vector decoded;
+    StreamDecoder<T>(decoded).parse(body);
+    measure<string>(name + " toJSON+dump", count, iterations, [&]() {
+        return decoded.toJSON().dump();
+    });
+}
+
+/**
+ * BranchProtection has no listing of its own; an audit reads one per repo.
+ */
+static void benchProtection(size_t count, int scale) {
+    string body = makePayload(protectionSample, nullptr, count);
+    int iterations = iterationsFor(count, scale);
+
+    measure<std::shared_ptr<std::vector<BranchProtection>>>("BranchProtection fromJSON", count, iterations, [&]() {
+        auto vec = std::make_shared<std::vector<BranchProtection>>();
+        JSON json = JSON::parse(body);
+        vec->resize(json.size());
+        for (size_t index = 0; index < json.size(); ++index) {
+            (*vec)[index].fromJSON(json[index]);
+        }
+        return vec;
+    });
+
+    std::vector<BranchProtection> decoded;
+    for (const JSON &item: JSON::parse(body)) {
+        decoded.emplace_back();
+        decoded.back().fromJSON(item);
+    }
+    measure<string>("BranchProtection toJSON+dump", count, iterations, [&]() {
+        JSON json = JSON::array();
+        for (const BranchProtection &bp: decoded) {
+            json.push_back(bp.toJSON());
+        }
+        return json.dump();
+    });
+
+    measure<string>("UpdateBranchProtection toJSON+dump", count, iterations, [&]() {
+        JSON json = JSON::array();
+        for (const BranchProtection &bp: decoded) {
+            json.push_back(UpdateBranchProtection(bp).toJSON());
+        }
+        return json.dump();
+    });
+}
+
+int main(int argc, char **argv) {
+    int scale = argc > 1 ? std::max(atoi(argv[1]), 1) : 1;
+
+    cout << std::left << std::setw(36) << "" << std::right
+         << std::setw(8) << "objects" << std::setw(12) << "ns/object"
+         << std::setw(12) << "allocs/obj" << std::setw(12) << "bytes/obj" << endl;
+
+    for (size_t count: { size_t(1), size_t(100), size_t(10000) }) {
+        benchListing<Repository>("Repository", repositorySample, "name", count, scale);
+        benchListing<Team>("Team", teamSample, "slug", count, scale);
+        benchListing<User>("User", userSample, "login", count, scale);
+        benchProtection(count, scale);
+        cout << endl;
+    }
+
+    return 0;
+}
@@ -111,6 +111,53 @@ void GitTools::BranchProtection::fromJSON(const JSON &json) {
     name = stringValue(json, "name");
 }
 
+/**
+ * Read one of GraphQL's BranchProtectionRule nodes. We rewrite it in the shape the
+ * REST API uses and read that, so the two can't drift apart. The rule's pattern
+ * becomes our name.
+ */
+void GitTools::BranchProtection::fromGraphQL(const JSON &rule) {
+    auto flag = [&](const char *key) {
+        JSON json = JSON::object();
+        json["enabled"] = boolValue(rule, key);
+        return json;
+    };
+
+    JSON json = JSON::object();
+    json["name"] = stringValue(rule, "pattern");
+    json["enforce_admins"] = flag("isAdminEnforced");
+    json["allow_deletions"] = flag("allowsDeletions");
+    json["allow_force_pushes"] = flag("allowsForcePushes");
+    json["allow_fork_syncing"] = flag("lockAllowsFetchAndMerge");
+    json["block_creations"] = flag("blocksCreations");
+    json["lock_branch"] = flag("lockBranch");
+    json["required_conversation_resolution"] = flag("requiresConversationResolution");
+    json["required_linear_history"] = flag("requiresLinearHistory");
+    json["required_signatures"] = flag("requiresCommitSignatures");
+
+    if (boolValue(rule, "requiresApprovingReviews")) {
+        JSON reviews = JSON::object();
+        reviews["dismiss_stale_reviews"] = boolValue(rule, "dismissesStaleReviews");
+        reviews["require_code_owner_reviews"] = boolValue(rule, "requiresCodeOwnerReviews");
+        reviews["require_last_push_approval"] = boolValue(rule, "requireLastPushApproval");
+        reviews["required_approving_review_count"] = intValue(rule, "requiredApprovingReviewCount");
+        json["required_pull_request_reviews"] = reviews;
+    }
+
+    if (boolValue(rule, "requiresStatusChecks")) {
+        JSON checks = JSON::object();
+        checks["strict"] = boolValue(rule, "requiresStrictStatusChecks");
+        checks["contexts"] = jsonArray(rule, "requiredStatusCheckContexts");
+        json["required_status_checks"] = checks;
+    }
+
+    if (boolValue(rule, "restrictsPushes")) {
+        json["restrictions"] = JSON::object({ {"users", JSON::array()}, {"teams", JSON::array()} });
+    }
+
+    fromJSON(json);
+}
+
 //======================================================================
 //
 //======================================================================
@@ -129,7 +176,7 @@ JSON GitTools::RequiredPullRequestReviews::toJSON() const {
     json["dismiss_stale_reviews"] = dismissStaleReviews;
     json["require_code_owner_reviews"] = requireCodeOwnerReviews;
     json["require_last_push_approval"] = requireLastPushApproval;
-    json["required_appriving_review_count"] = requiredApprovingReviewCount;
+    json["required_approving_review_count"] = requiredApprovingReviewCount;
 
     return json;
 }
@@ -143,10 +190,10 @@ void GitTools::RequiredPullRequestReviews::fromJSON(const JSON &json)
         dismissalRestrictions.fromJSON( jsonValue(json, "dismissal_restrictions") );
         bypassPullRequestAllowances.fromJSON( jsonValue(json, "bypass_pull_request_allowances") );
         url = stringValue(json, "url");
-        dismissStaleReviews = boolValue(json, "dismiss_stale_review");
+        dismissStaleReviews = boolValue(json, "dismiss_stale_reviews");
         requireCodeOwnerReviews = boolValue(json, "require_code_owner_reviews");
-        requiredApprovingReviewCount = intValue(json, "required_appriving_review_count");
-        requireLastPushApproval = boolValue(json, "require_last_push_approvall");
+        requiredApprovingReviewCount = intValue(json, "required_approving_review_count");
+        requireLastPushApproval = boolValue(json, "require_last_push_approval");
 
         markSet();
     }
@@ -194,7 +241,6 @@ JSON GitTools::Restrictions::toJSON() const {
 void GitTools::Restrictions::fromJSON(const JSON &json) {
     markClear();
     if (!json.empty()) {
-        cout << "Setting restrictions from: " << json.dump(2) << endl;
         markSet();
 
         url = stringValue(json, "url");
@@ -433,7 +479,7 @@ GitTools::UpdateBranchProtection & GitTools::UpdateBranchProtection::operator=(c
 
     allowDeletions = bp.getAllowDeletions();
     allowForkSyncing = bp.getAllowForkSyncing();
-    blockCreations = bp.getAllowDeletions();
+    blockCreations = bp.getBlockCreations();
     lockBranch = bp.getLockBranch();
     requiredConversationResolution = bp.getRequiredConversationResolution();
     requiredLinearHistory = bp.getRequiredLinearHistory();
@@ -467,6 +513,30 @@ JSON GitTools::UpdateBranchProtection::toJSON() const {
     return json;
 }
 
+/**
+ * The top-level keys whose toJSON() values differ from other's. Sections only appear
+ * once set (see markIfChanged), so a change that puts things back the way they were
+ * isn't a difference.
+ */
+std::vector<std::string> GitTools::UpdateBranchProtection::diff(const UpdateBranchProtection &other) const {
+    JSON ours = toJSON();
+    JSON theirs = other.toJSON();
+    std::vector<std::string> rv;
+
+    for (auto it = ours.begin(); it != ours.end(); ++it) {
+        if (!theirs.contains(it.key()) || theirs[it.key()] != it.value()) {
+            rv.push_back(it.key());
+        }
+    }
+    for (auto it = theirs.begin(); it != theirs.end(); ++it) {
+        if (!ours.contains(it.key())) {
+            rv.push_back(it.key());
+        }
+    }
+
+    return rv;
+}
+
 /**
  * Read from JSON.
  */
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <showlib/JSONSerializable.h>
 #include <showlib/StringVector.h>
 
@@ -97,19 +98,25 @@ public:
 
     protected:
         std::string context;
-        int appId;
+        int appId = 0;
     };
 
     JSON toJSON() const override;
     void fromJSON(const JSON &) override;
 
+    /** If set, the branch must be up to date with the base before merging. */
+    bool getStrict() const { return strict; }
+
+    /** The names of the checks that must pass. */
+    const ShowLib::StringVector & getContexts() const { return contexts; }
+
 protected:
     std::string url;
     std::string contextsURL;
     std::string enforcementLevel;
     ShowLib::StringVector contexts;
     Check::Vector checks;
-    bool strict;
+    bool strict = false;
 };
 
 
@@ -214,9 +221,11 @@ public:
     JSON toJSON() const override;
     void fromJSON(const JSON &) override;
 
+    bool getEnabled() const { return enabled; }
+
 protected:
     std::string url;
-    bool enabled;
+    bool enabled = false;
 };
 
 /**
@@ -253,6 +262,7 @@ class GitTools::BranchProtection: public ShowLib::JSONSerializable {
 public:
     JSON toJSON() const override;
     void fromJSON(const JSON &) override;
+    void fromGraphQL(const JSON &rule);
 
     // Getters and setters. For getters, we have a bunch that are
     // non-const as you might need to call setters on the resulting objects.
@@ -357,6 +367,9 @@ public:
 
     UpdateBranchProtection & operator=(const BranchProtection &);
 
+    /** The keys of toJSON() whose values differ from other's. Empty means a PUT would change nothing. */
+    std::vector<std::string> diff(const UpdateBranchProtection &other) const;
+
     bool getAllowDeletions() const { return allowDeletions; }
 
     const TriValueBoolean & getAllowForcePushes() const { return allowForcePushes; }
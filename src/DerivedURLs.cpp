@@ -0,0 +1,83 @@
+#include <cstring>
+
+#include "DerivedURLs.h"
+
+using namespace GitTools;
+
+/**
+ * Record the value for template index.
+ */
+void DerivedURLs::set(const std::string &base, const Template *table, size_t index, const std::string &value) {
+    uint64_t bit = uint64_t(1) << index;
+    derived &= ~bit;
+
+    for (auto it = overrides.begin(); it != overrides.end(); ++it) {
+        if (it->first == index) {
+            overrides.erase(it);
+            break;
+        }
+    }
+
+    if (value.empty()) {
+        return;
+    }
+
+    if (follows(base, table[index].suffix, value)) {
+        derived |= bit;
+    }
+    else {
+        overrides.emplace_back(static_cast<uint8_t>(index), value);
+    }
+}
+
+/**
+ * We have the base url at last. Any value we had to keep that is base + suffix after
+ * all becomes a bit.
+ */
+void DerivedURLs::rebase(const std::string &base, const Template *table) {
+    size_t kept = 0;
+    for (size_t at = 0; at < overrides.size(); ++at) {
+        uint8_t index = overrides[at].first;
+        if (follows(base, table[index].suffix, overrides[at].second)) {
+            derived |= uint64_t(1) << index;
+        }
+        else {
+            if (kept != at) {
+                overrides[kept] = std::move(overrides[at]);
+            }
+            ++kept;
+        }
+    }
+    if (kept < overrides.size()) {
+        overrides.resize(kept);
+        overrides.shrink_to_fit();
+    }
+}
+
+bool DerivedURLs::follows(const std::string &base, const char *suffix, const std::string &value) {
+    size_t suffixLength = strlen(suffix);
+    return !base.empty()
+        && value.size() == base.size() + suffixLength
+        && value.compare(0, base.size(), base) == 0
+        && value.compare(base.size(), suffixLength, suffix) == 0;
+}
+
+/**
+ * Produce the value for template index.
+ */
+std::string DerivedURLs::get(const std::string &base, const Template *table, size_t index) const {
+    if (derived & (uint64_t(1) << index)) {
+        return base + table[index].suffix;
+    }
+    for (const auto & [which, value]: overrides) {
+        if (which == index) {
+            return value;
+        }
+    }
+    return std::string{};
+}
+
+void DerivedURLs::clear() {
+    derived = 0;
+    overrides.clear();
+}
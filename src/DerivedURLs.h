@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace GitTools {
+    class DerivedURLs;
+}
+
+/**
+ * GitHub objects carry dozens of URL templates, nearly all of which are the object's
+ * own url plus a fixed suffix:
+ *
+ *     "url":           "https://api.github.com/repos/octocat/Hello-World"
+ *     "branches_url":  "https://api.github.com/repos/octocat/Hello-World/branches{/branch}"
+ *
+ * Rather than store each one, we keep a bit per template saying "this was url + suffix",
+ * and only store the value outright on the rare occasion it was something else. The
+ * owner supplies the base url and a table of templates on every call.
+ *
+ * Templates can arrive before url does (sorted keys put "branches_url" ahead of "url"),
+ * so they're kept as they are until then, and the owner calls rebase() once it has url.
+ */
+class GitTools::DerivedURLs
+{
+public:
+    class Template {
+    public:
+        const char * key;
+        const char * suffix;
+    };
+
+    void set(const std::string &base, const Template *table, size_t index, const std::string &value);
+    std::string get(const std::string &base, const Template *table, size_t index) const;
+    void rebase(const std::string &base, const Template *table);
+    void clear();
+
+protected:
+    static bool follows(const std::string &base, const char *suffix, const std::string &value);
+
+    /** Bit N set means template N is base + table[N].suffix. */
+    uint64_t derived = 0;
+
+    /** Values that didn't follow the pattern. Empty values aren't stored at all. */
+    std::vector<std::pair<uint8_t, std::string>> overrides;
+};
@@ -5,17 +5,28 @@
 //		GIT_USER	(default of "git" is probably fine)
 //		GIT_TOKEN	This is your personal API token.
 //======================================================================
+#include <algorithm>
+#include <chrono>
+#include <fnmatch.h>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 
 #include <showlib/OptionHandler.h>
 #include <showlib/Ranges.h>
 #include <showlib/StringUtils.h>
 
+#include "Log.h"
+#include "OrgSnapshot.h"
+#include "Plan.h"
+#include "RecordWriter.h"
+#include "RepositoryFilter.h"
 #include "Server.h"
+#include "WorkerPool.h"
 
 using std::cout;
-using std::cerr;
 using std::endl;
 using std::string;
 using namespace GitTools;
@@ -26,11 +37,24 @@ enum class Action {
     GetRepos,
     GetTeams,
     GetUsers,
+    RateLimit,
+    Sync,
     CheckBranchProtection,
     AddBranchProtection,
-    DeleteBranchProtection
+    DeleteBranchProtection,
+    AuditBranchProtection,
+    ApplyPlan
 };
 
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/** Above this many names, addUser fetches full listings instead of looking names up one by one. */
+static constexpr size_t TargetedLookupLimit = 10;
+
 enum class Option {
     EnforceAdmins_Set,
     EnforceAdmins_Clear,
@@ -43,22 +67,40 @@ enum class Option {
 class GitTool {
 public:
     void processArgs(int, char **);
+    void setWhere(const char *);
+    void setLogLevel(const char *);
+    void setFormat(const char *);
+    void checkGraphQLOptions();
     void run();
 
+    std::unique_ptr<RecordWriter> recordWriter(const std::vector<std::string> &defaultFields);
     void getRepositories();
     void getTeams();
     void getUsers();
     void addUser();
+    void showRateLimit();
+    void sync();
+    bool useSnapshot();
+    Repository::Vector selectRepositories(Repository::Fields fields);
+    std::vector<std::pair<Server::RepositoryName, Server::BranchName>> protectionTargets();
 
     void checkBranchProtection();
     void addBranchProtection();
+    void applyOptions(UpdateBranchProtection &ubp);
     void deleteBranchProtection();
+    void auditBranchProtection();
+    void carryOut(Plan &plan, double planSeconds, size_t reads);
+    size_t applyPlan(const Plan &plan);
+    void applySavedPlan();
+    std::vector<Server::BranchTarget> auditTargets(size_t &failures);
+    static JSON auditEntry(const std::string &repo, const std::string &branch, const BranchProtection *bp);
 
     Action action = Action::Unknown;
     Server server;
     Server::OwnerName orgName;
     Server::RepositoryName repoName;
     Server::BranchName branchName = Server::BranchName("main");
+    bool branchGiven = false;
     ShowLib::StringVector repoNames;
     ShowLib::StringVector loginNames;
 
@@ -66,6 +108,29 @@ public:
 
     Server::PermissionName permName;
     bool checkForUsers = true;
+    bool useGraphQL = false;
+    bool workersGiven = false;
+    bool showStats = false;
+    std::string tracePath;
+
+    /** What main returns. Once run() has started, set this rather than calling exit(), so --stats, --trace and the log are still written. */
+    int exitStatus = 0;
+
+    /** With --plan, the changing actions write a Plan here instead of making changes. */
+    std::string planPath;
+    std::string applyPath;
+
+    /** With --format, listings are written for other programs. */
+    bool formatGiven = false;
+    RecordWriter::Format format = RecordWriter::Format::NDJSON;
+    std::vector<std::string> outputFields;
+
+    /** Selects repos for --repos, the add-user actions and "*" for branch protection. */
+    RepositoryFilter where;
+
+    OrgSnapshot snapshot;
+    time_t snapshotMaxAge = 0;
+    bool fullSync = false;
 };
 
 /**
@@ -74,9 +139,39 @@ public:
 int main(int argc, char **argv) {
     cout << std::boolalpha;
     GitTool tool;
+    tool.server.setPageWorkers(4);
+    int rv = 0;
+
+    // Transport failures, bad replies and the like end up here. Report them like
+    // any other error rather than letting them abort us, and still write the
+    // stats and trace, which say what we got done.
+    try {
+        tool.processArgs(argc, argv);
+        tool.run();
+        rv = tool.exitStatus;
+    }
+    catch (const std::exception &e) {
+        Log::error(e.what());
+        rv = 1;
+    }
+
+    if (tool.showStats) {
+        std::ostringstream report;
+        tool.server.getStats().report(report);
+        Log::info(ShowLib::trim(report.str()));
+    }
+
+    if (!tool.tracePath.empty() && !tool.server.getTracer().save(tool.tracePath)) {
+        Log::error("Couldn't write " + tool.tracePath);
+    }
+
+    const ResponseCache * cache = tool.server.getCache();
+    if (cache != nullptr) {
+        Log::info("Cache: " + std::to_string(cache->getHits()) + " hits, " + std::to_string(cache->getMisses()) + " misses.");
+    }
 
-    tool.processArgs(argc, argv);
-    tool.run();
+    Log::instance().flush();
+    return rv;
 }
 
 void GitTool::processArgs(int argc, char ** argv) {
@@ -85,31 +180,50 @@ void GitTool::processArgs(int argc, char ** argv) {
     args.addArg("host", [&](const char *value){ server.hostname = value; }, "github.com", "Specify a server");
     args.addArg("username", [&](const char *value){ server.username = value; }, "foofoo", "Specify your username");
     args.addArg("token", [&](const char *value){ server.apiToken = value; }, "12345", "Your API Token");
+    args.addArg("cache", [&](const char *value){ server.enableCache(value); }, "~/.cache/gittools", "Cache responses here and revalidate them with ETags");
+    args.addArg("log-level", [&](const char *value){ setLogLevel(value); }, "info", "Show diagnostics at this level and above: debug, info, warning, error or off");
+    args.addNoArg("quiet", [&](const char *){ Log::instance().setLevel(Log::Level::Error); }, "Show only errors");
+    args.addArg("trace", [&](const char *value){ tracePath = value; server.getTracer().enable(); }, "trace.json", "Write a Chrome trace of requests, page decodes, bulk items and rate limit waits here at exit");
+    args.addNoArg("stats", [&](const char *){ showStats = true; }, "At exit, show request times (p50/p95/p99 and phases), sizes and statuses per endpoint");
+    args.addArg("workers", [&](const char *value){ server.setPageWorkers(atoi(value)).setBulkWorkers(atoi(value)); workersGiven = true; }, "4", "How many requests to run at once (1 == one at a time)");
 
     args.addArg("login",  [&](const char *value){ loginNames.add(value); },                  "foo",  "A user to add to a repo");
     args.addArg("repo",   [&](const char *value){ repoNames.add(ShowLib::trim(value)); },    "Foo",  "A repository name (without owner)");
-    args.addArg("branch", [&](const char *value){ branchName = Server::BranchName(value); }, "main", "The branch name");
+    args.addArg("branch", [&](const char *value){ branchName = Server::BranchName(value); branchGiven = true; }, "main", "The branch name");
+    args.addArg("where", [&](const char *value){ setWhere(value); }, "archived=false and language=Go",
+        "Only repos matching this. Fields: " + RepositoryFilter::fieldNames());
 
     args.addNoArg("add-admin", [&](const char *){ action = Action::AddUser; permName = Server::PermissionName("admin"); }, "Add an admin to a repo");
     args.addNoArg("add-writer", [&](const char *){ action = Action::AddUser; permName = Server::PermissionName("push"); }, "Add a writer to a repo");
-    args.addNoArg("repos", [&](const char *){ action = Action::GetRepos; }, "Retrieve repositories");
+    args.addNoArg("repos", [&](const char *){ action = Action::GetRepos; }, "Retrieve repositories (of --org if given, else your own)");
     args.addNoArg("teams", [&](const char *){ action = Action::GetTeams; }, "Retrieve teams");
     args.addNoArg("users", [&](const char *){ action = Action::GetUsers; }, "Retrieve users");
+    args.addArg("format", [&](const char *value){ setFormat(value); }, "csv", "For repos, teams and users: write ndjson, csv or tsv as each page arrives. See --fields");
+    args.addArg("fields", [&](const char *value){ outputFields = RecordWriter::fieldsNamed(value); }, "name,owner.login", "With --format: these JSON keys, in this order. Dots reach into objects");
+    args.addNoArg("sync", [&](const char *){ action = Action::Sync; }, "Update the local snapshot of --org");
+    args.addNoArg("full", [&](const char *){ fullSync = true; }, "For sync: re-read everything rather than just what changed");
+    args.addArg("max-age", [&](const char *value){ snapshotMaxAge = atol(value); }, "600", "Serve repos/teams/users from the --org snapshot if synced within this many seconds");
+    args.addNoArg("rate-limit", [&](const char *){ action = Action::RateLimit; }, "Show the remaining API request budget");
 
     args.addNoArg("no-usercheck", [&](const char *){ checkForUsers = false; }, "Don't validate the loginNames given.");
 
-    args.addArg("org", [&](const char *value){ orgName = Server::OwnerName(value); }, "foofoo", "Use this organization (used by users/teams calls)");
+    args.addArg("org", [&](const char *value){ orgName = Server::OwnerName(value); }, "foofoo", "Use this organization (used by repos/users/teams calls)");
+
+    args.addArg("check-branch-protection", [&](const char *value){ action = Action::CheckBranchProtection; repoName = Server::RepositoryName(value); }, "repo", "Display branch protection. See --branch. '*' means every repo matching --where");
+    args.addArg("delete-branch-protection", [&](const char *value){ action = Action::DeleteBranchProtection; repoName = Server::RepositoryName(value); }, "repo", "Delete branch protection. See --branch. '*' means every repo matching --where");
+    args.addNoArg("audit-branch-protection", [&](const char *){ action = Action::AuditBranchProtection; }, "Report protection of each --org repo's default branch (or --branch, which may be a pattern) as JSON. See --where");
+    args.addNoArg("graphql", [&](const char *){ useGraphQL = true; }, "For audit-branch-protection: read the rules with GraphQL, 100 repos per request");
+    args.addArg("add-branch-protection", [&](const char *value){ action = Action::AddBranchProtection; repoName = Server::RepositoryName(value); }, "repo", "Add branch protection. See --branch and other options below. '*' means every repo matching --where");
 
-    args.addArg("check-branch-protection", [&](const char *value){ action = Action::CheckBranchProtection; repoName = Server::RepositoryName(value); }, "repo", "Display branch protection. See --branch");
-    args.addArg("delete-branch-protection", [&](const char *value){ action = Action::DeleteBranchProtection; repoName = Server::RepositoryName(value); }, "repo", "Delete branch protection. See --branch");
-    args.addArg("add-branch-protection", [&](const char *value){ action = Action::AddBranchProtection; repoName = Server::RepositoryName(value); }, "repo", "Add branch protection. See --branch and other options below.");
+    args.addArg("plan", [&](const char *value){ planPath = value; }, "plan.json", "For add-admin, add-writer and add/delete-branch-protection: write the changes here instead of making them");
+    args.addArg("apply", [&](const char *value){ action = Action::ApplyPlan; applyPath = value; }, "plan.json", "Make the changes in a file written with --plan. See --workers");
 
     // These flags are for add-branch-protection
     args.addNoArg("enforce-admins",    [&](const char *) { options.push_back(Option::EnforceAdmins_Set); },   "For add-branch-protection: admins cannot bypass the other flags.");
     args.addNoArg("no-enforce-admins", [&](const char *) { options.push_back(Option::EnforceAdmins_Clear); }, "For add-branch-protection: admins can bypass the other flags.");
 
-    args.addNoArg("allow-delete",      [&](const char *) { options.push_back(Option::Allow_Delete_Clear); }, "For add-branch-protection: allow_deletions == true.");
-    args.addNoArg("no-allow-delete",   [&](const char *) { options.push_back(Option::Allow_Delete_Set); },   "For add-branch-protection: allow_deletions == false.");
+    args.addNoArg("allow-delete",      [&](const char *) { options.push_back(Option::Allow_Delete_Set); },   "For add-branch-protection: allow_deletions == true.");
+    args.addNoArg("no-allow-delete",   [&](const char *) { options.push_back(Option::Allow_Delete_Clear); }, "For add-branch-protection: allow_deletions == false.");
 
     args.addNoArg("pull-requests",     [&](const char *) { options.push_back(Option::Require_PullRequests_Set); },   "For add-branch-protection: Require pull requests before merging");
     args.addNoArg("no-pull-requests",  [&](const char *) { options.push_back(Option::Require_PullRequests_Clear); }, "For add-branch-protection: Do not require pull requests before merging");
@@ -118,125 +232,426 @@ void GitTool::processArgs(int argc, char ** argv) {
         exit(0);
     }
 
+    if (useGraphQL && action == Action::AuditBranchProtection) {
+        checkGraphQLOptions();
+    }
+
     if (server.username.empty() || server.apiToken.empty()) {
-        cerr << "No authentication may be a problem." << endl;
+        Log::warning("No authentication may be a problem.");
+    }
+}
+
+/**
+ * Compile the --where expression now, so a typo stops us before we fetch anything.
+ */
+void GitTool::setWhere(const char *value) {
+    try {
+        where = RepositoryFilter(value);
+    }
+    catch (const std::invalid_argument &e) {
+        Log::error(e.what());
+        exit(2);
+    }
+}
+
+/**
+ * --log-level. Like --where, a bad value stops us at once.
+ */
+void GitTool::setLogLevel(const char *value) {
+    try {
+        Log::instance().setLevel(Log::levelNamed(value));
+    }
+    catch (const std::invalid_argument &e) {
+        Log::error(e.what());
+        exit(2);
+    }
+}
+
+/**
+ * --format. Checked now, like --where.
+ */
+void GitTool::setFormat(const char *value) {
+    try {
+        format = RecordWriter::formatNamed(value);
+        formatGiven = true;
+    }
+    catch (const std::invalid_argument &e) {
+        Log::error(e.what());
+        exit(2);
+    }
+}
+
+/**
+ * --graphql with the audit. Like --where, anything it can't do stops us before we
+ * fetch anything. The GraphQL reply has each repo's rules but not its branches, so
+ * it can't expand a --branch pattern, and it lacks a few fields --where might name.
+ */
+void GitTool::checkGraphQLOptions() {
+    if (branchGiven && branchName.get().find_first_of("*?[") != string::npos) {
+        Log::error("--graphql can't match --branch " + branchName.get() + " against each repo's branches. Leave out --graphql to do that.");
+        exit(2);
+    }
+
+    const std::vector<std::string> &missing = Server::graphQLMissingFields();
+    for (const std::string &name: where.getComparedFields()) {
+        if (std::find(missing.begin(), missing.end(), name) != missing.end()) {
+            Log::error("--graphql can't read " + name + " for --where. Leave out --graphql to do that.");
+            exit(2);
+        }
     }
 }
 
 void GitTool::run() {
     switch (action) {
-        case Action::Unknown: cerr << "Please specify one of [repos]" << endl; break;
+        case Action::Unknown: Log::error("Please specify one of [repos]"); break;
 
         case Action::GetRepos: getRepositories(); break;
         case Action::GetTeams: getTeams(); break;
         case Action::GetUsers: getUsers(); break;
         case Action::AddUser: addUser(); break;
+        case Action::RateLimit: showRateLimit(); break;
+        case Action::Sync: sync(); break;
 
         case Action::CheckBranchProtection: checkBranchProtection(); break;
         case Action::AddBranchProtection: addBranchProtection(); break;
         case Action::DeleteBranchProtection: deleteBranchProtection(); break;
+        case Action::AuditBranchProtection: auditBranchProtection(); break;
+        case Action::ApplyPlan: applySavedPlan(); break;
+
+        default: Log::error("Unknown action."); break;
+    }
+}
+
+/**
+ * If they allow it, load a fresh enough snapshot of the org.
+ */
+bool GitTool::useSnapshot() {
+    if (snapshotMaxAge <= 0 || orgName.get().empty()) {
+        return false;
+    }
+
+    snapshot = OrgSnapshot(orgName);
+    return snapshot.load() && snapshot.isFresh(snapshotMaxAge);
+}
 
-        default: cout << "Unknown action." << endl; break;
+/**
+ * With --format, a writer for cout using --fields or, for CSV and TSV without them,
+ * these. Without it, nullptr: we print lines for people.
+ */
+std::unique_ptr<RecordWriter> GitTool::recordWriter(const std::vector<std::string> &defaultFields) {
+    if (!formatGiven) {
+        return nullptr;
     }
+    bool useDefaults = outputFields.empty() && format != RecordWriter::Format::NDJSON;
+    return std::make_unique<RecordWriter>(cout, format, useDefaults ? defaultFields : outputFields);
 }
 
 void GitTool::getRepositories() {
-    Repository::Vector repos = server.getRepositories();
-    cout << "Number of repos: " << repos.size() << endl;
-    for (const Repository::Pointer & repo: repos) {
-        cout << "Repo: " << repo->name << " -- " << repo->url << endl;
+    std::unique_ptr<RecordWriter> writer = recordWriter({ "name", "full_name", "html_url" });
+
+    // Decode only what we'll filter on and write. Without a field list, ndjson writes everything.
+    Repository::Fields fields = Repository::IdentityFields | where.getFields();
+    if (writer != nullptr) {
+        if (writer->getFields().empty()) {
+            fields = Repository::AllFields;
+        }
+        for (const string &field: writer->getFields()) {
+            fields |= Repository::fieldsFor(field.substr(0, field.find('.')));
+        }
+    }
+
+    size_t count = 0;
+    auto print = [&](const Repository::Vector &page) {
+        for (const Repository::Pointer & repo: page) {
+            if (!where.matches(*repo)) {
+                continue;
+            }
+            if (writer != nullptr) {
+                writer->write(repo->toJSON());
+            }
+            else {
+                cout << "Repo: " << repo->name << " -- " << repo->url << "\n";
+            }
+            ++count;
+        }
+        if (writer != nullptr) {
+            writer->flush();
+        }
+        return true;
+    };
+
+    if (useSnapshot()) {
+        print(snapshot.getRepositories());
+    }
+    else if (!orgName.get().empty()) {
+        server.repositories(orgName, fields).forEachPage(print);
+    }
+    else {
+        server.repositories(fields).forEachPage(print);
+    }
+
+    if (writer == nullptr) {
+        cout << "Number of repos: " << count << endl;
     }
 }
 
 void GitTool::getTeams() {
-    Team::Vector teams = server.getTeams(orgName);
-    cout << "Number of teams: " << teams.size() << endl;
-    for (const Team::Pointer & team: teams) {
-        cout << "Team: " << team->name << " -- " << team->url << endl;
+    std::unique_ptr<RecordWriter> writer = recordWriter({ "name", "slug", "html_url" });
+
+    size_t count = 0;
+    auto print = [&](const Team::Vector &page) {
+        for (const Team::Pointer & team: page) {
+            if (writer != nullptr) {
+                writer->write(team->toJSON());
+            }
+            else {
+                cout << "Team: " << team->name << " -- " << team->url << "\n";
+            }
+            ++count;
+        }
+        if (writer != nullptr) {
+            writer->flush();
+        }
+        return true;
+    };
+
+    if (useSnapshot()) {
+        print(snapshot.getTeams());
+    }
+    else {
+        server.teams(orgName).forEachPage(print);
+    }
+
+    if (writer == nullptr) {
+        cout << "Number of teams: " << count << endl;
     }
 }
 
+void GitTool::getUsers() {
+    std::unique_ptr<RecordWriter> writer = recordWriter({ "login", "name", "email" });
+
+    size_t count = 0;
+    auto print = [&](const User::Vector &page) {
+        for (const User::Pointer & user: page) {
+            ++count;
+            if (writer != nullptr) {
+                writer->write(user->toJSON());
+                continue;
+            }
+            cout << "User Login: " << user->login;
+            if (user->name.size() > 0) {
+                cout << " (" << user->name << ")";
+            }
+            if (user->email.size() > 0) {
+                cout << " -- " << user->email;
+            }
+            cout << "\n";
+        }
+        if (writer != nullptr) {
+            writer->flush();
+        }
+        return true;
+    };
+
+    if (useSnapshot()) {
+        print(snapshot.getUsers());
+    }
+    else {
+        server.users(orgName).forEachPage(print);
+    }
 
+    if (writer == nullptr) {
+        cout << "Number of users: " << count << endl;
+    }
+}
 
-void GitTool::getUsers() {
-    User::Vector users = server.getUsers(orgName);
-    cout << "Number of users: " << users.size() << endl;
-    for (const User::Pointer & user: users) {
-        cout << "User Login: " << user->login;
-        if (user->name.size() > 0) {
-            cout << " (" << user->name << ")";
+/**
+ * The repos of --org (or your own) that match --where. We ask for just the fields
+ * the expression needs, plus these.
+ */
+Repository::Vector GitTool::selectRepositories(Repository::Fields fields) {
+    Repository::Vector rv;
+    auto keep = [&](const Repository::Pointer & repo) {
+        if (where.matches(*repo)) {
+            rv.push_back(repo);
         }
-        if (user->email.size() > 0) {
-            cout << " -- " << user->email;
+        return true;
+    };
+
+    fields |= where.getFields();
+    if (useSnapshot()) {
+        for (const Repository::Pointer & repo: snapshot.getRepositories()) {
+            keep(repo);
         }
-        cout << endl;
     }
+    else if (!orgName.get().empty()) {
+        server.repositories(orgName, fields).forEach(keep);
+    }
+    else {
+        server.repositories(fields).forEach(keep);
+    }
+    return rv;
 }
 
 /**
- * Give this user admin access to this repo.
+ * Bring the local snapshot of this org up to date.
  */
-void GitTool::addUser() {
-    cout << "Add User..." << endl;
+void GitTool::sync() {
+    if (orgName.get().empty()) {
+        Log::error("Please specify --org.");
+        return;
+    }
+
+    snapshot = OrgSnapshot(orgName);
+    if (!fullSync) {
+        snapshot.load();
+    }
+    snapshot.sync(server, fullSync);
+
+    if (!snapshot.save()) {
+        Log::error("Unable to write " + snapshot.getPath());
+        return;
+    }
+
+    cout << "Snapshot of " << orgName.get() << ": "
+         << snapshot.getRepositories().size() << " repos, "
+         << snapshot.getTeams().size() << " teams, "
+         << snapshot.getUsers().size() << " users." << endl;
+}
+
+/**
+ * Show how much of our request budget is left.
+ */
+void GitTool::showRateLimit() {
+    RateLimiter::Budget budget = server.refreshRateLimit();
+    if (!budget.isKnown()) {
+        cout << "The server did not report a rate limit." << endl;
+        return;
+    }
 
-    Repository::Vector repos = server.getRepositories();
-    User::Vector users;
+    long secondsToReset = static_cast<long>(budget.resetAt - time(nullptr));
+    cout << "Remaining: " << budget.remaining << " of " << budget.limit
+         << " (resets in " << std::max(0L, secondsToReset) << " seconds)" << endl;
+}
 
-    if (checkForUsers) {
-        users = server.getUsers(orgName);
+/**
+ * Give these users access to these repos.
+ */
+void GitTool::addUser() {
+    Log::info("Add User...");
+    Clock::time_point started = Clock::now();
+
+    // A full listing of a big org is dozens of pages, so for a handful of
+    // names it's cheaper to look each one up directly.
+    bool listRepos = repoNames.size() > TargetedLookupLimit;
+    bool listUsers = checkForUsers && loginNames.size() > TargetedLookupLimit;
+
+    Repository::Index repos;
+    User::Index users;
+
+    // The listings can be thousands long, so read them packed. Like the lookups, we
+    // look for the repos in --org if it's given.
+    if (listRepos) {
+        Repository::Packed list;
+        if (!orgName.get().empty()) {
+            server.repositories(orgName, Repository::IdentityFields).collect(list);
+        }
+        else {
+            server.repositories(Repository::IdentityFields).collect(list);
+        }
+        repos.build(list, Repository::indexByName);
+    }
+    if (listUsers) {
+        User::Packed list;
+        server.users(orgName).collect(list);
+        users.build(list, User::indexByLogin);
     }
 
+    std::vector<Server::RepositoryName> validRepos;
     for (const std::shared_ptr<string> &nPtr: repoNames) {
-        string repoName = ShowLib::toLower(*nPtr);
-        Repository::Pointer repo = repos.findIf( [=](const Repository::Pointer & ptr) {
-            return ShowLib::toLower(ptr->name) == repoName;
-        } );
+        Repository::Pointer repo = listRepos
+            ? repos.find(*nPtr)
+            : server.getRepository(orgName, Server::RepositoryName(*nPtr));
 
         if (repo == nullptr) {
-            cout << "Repo " << repoName << " not found." << endl;
+            Log::warning("Repo " + *nPtr + " not found.");
             continue;
         }
+        validRepos.push_back(Server::RepositoryName(repo->name));
+    }
 
-        for (const std::shared_ptr<string> & uPtr: loginNames) {
-            string login = *uPtr;
+    if (!where.empty()) {
+        for (const Repository::Pointer &repo: selectRepositories(Repository::IdentityFields)) {
+            validRepos.push_back(Server::RepositoryName(repo->name));
+        }
+    }
 
-            if (checkForUsers) {
-                User::Pointer user = users.findIf( [=](const User::Pointer & ptr) { return ptr->login == login; } );
-                if (user == nullptr) {
-                    cout << "User " << login << " not found." << endl;
-                    continue;
-                }
+    std::vector<Server::UserName> validLogins;
+    for (const std::shared_ptr<string> & uPtr: loginNames) {
+        string login = *uPtr;
+
+        if (checkForUsers) {
+            bool found = listUsers
+                ? users.contains(login)
+                : server.isOrgMember(orgName, Server::UserName(login));
+            if (!found) {
+                Log::warning("User " + login + " not found.");
+                continue;
             }
+        }
+        validLogins.push_back(Server::UserName(login));
+    }
 
-            server.addUserToRepo(orgName, Server::RepositoryName(repo->name), Server::UserName(login), permName);
+    Plan plan(orgName);
+    for (const Server::RepositoryName &repo: validRepos) {
+        for (const Server::UserName &login: validLogins) {
+            plan.addCollaborator(repo, login, permName);
         }
     }
+    carryOut(plan, elapsedSince(started), 0);
 }
 
 /**
- * We're going to retrieve the branch protection information for this repo.
+ * The repo and branch for the branch protection actions. Repo "*" means every repo
+ * matching --where, and then without --branch we use each one's default branch.
  */
-void GitTool::checkBranchProtection() {
-    BranchProtection bp = server.getProtection(orgName, repoName, branchName);
-    if ( !bp.getEnabled() ) {
-        cout << "Protection not enabled.\n";
+std::vector<std::pair<Server::RepositoryName, Server::BranchName>> GitTool::protectionTargets() {
+    std::vector<std::pair<Server::RepositoryName, Server::BranchName>> rv;
+
+    if (repoName.get() != "*") {
+        rv.emplace_back(repoName, branchName);
+        return rv;
     }
-    else {
-        cout << "Protection:\n" << bp.toJSON().dump(2) << endl;
+
+    for (const Repository::Pointer &repo: selectRepositories(Repository::IdentityFields | Repository::BranchFields)) {
+        bool useDefault = !branchGiven && !repo->default_branch.empty();
+        rv.emplace_back(Server::RepositoryName(repo->name), useDefault ? Server::BranchName(repo->default_branch) : branchName);
     }
+    return rv;
 }
 
 /**
- * Apply the changes they've been specifying.
+ * We're going to retrieve the branch protection information for this repo.
  */
-void GitTool::addBranchProtection() {
-    if (options.empty()) {
-        cerr << "You specified no options.\n";
-        return;
+void GitTool::checkBranchProtection() {
+    for (const auto & [repo, branch]: protectionTargets()) {
+        if (repoName.get() == "*") {
+            cout << "Repo " << repo.get() << ", branch " << branch.get() << ":\n";
+        }
+        BranchProtection bp = server.getProtection(orgName, repo, branch);
+        if ( !bp.getEnabled() ) {
+            cout << "Protection not enabled.\n";
+        }
+        else {
+            cout << "Protection:\n" << bp.toJSON().dump(2) << endl;
+        }
     }
+}
 
-    BranchProtection bp = server.getProtection(orgName, repoName, branchName);
-    UpdateBranchProtection ubp ( bp );
+/**
+ * Apply the options to one branch's protection.
+ */
+void GitTool::applyOptions(UpdateBranchProtection &ubp) {
     for (const Option &option: options) {
         switch (option) {
             case Option::EnforceAdmins_Set:   ubp.setEnforceAdmins(true); break;
@@ -249,14 +664,337 @@ void GitTool::addBranchProtection() {
             case Option::Require_PullRequests_Clear: ubp.getRequiredPullRequestReviews().clearAll(); break;
         }
     }
-    cout << "Protections should become:\n" << ubp.toJSON().dump(2) << endl;
+}
+
+/**
+ * Apply the changes they've been specifying. We read every target's protection
+ * at once, apply the options to each, and PUT only those where that changes
+ * something. An unprotected branch always gets a PUT, as that's what protects it.
+ * A branch whose protection we can't read is skipped and makes the exit status 1.
+ */
+void GitTool::addBranchProtection() {
+    if (options.empty()) {
+        Log::error("You specified no options.");
+        return;
+    }
+
+    Clock::time_point started = Clock::now();
+    std::vector<Server::BranchTarget> targets = protectionTargets();
+    Plan plan(orgName);
+    size_t unchanged = 0;
+    size_t failed = 0;
+
+    for (const Server::ProtectionResult &result: server.getProtections(orgName, targets)) {
+        if (result.isError()) {
+            Log::error("Failed " + result.repoName + "/" + result.branchName + ": " + std::to_string(result.status) + " " + result.message);
+            ++failed;
+            continue;
+        }
+
+        UpdateBranchProtection current ( result.protection );
+        UpdateBranchProtection ubp = current;
+        applyOptions(ubp);
+
+        std::vector<std::string> changes = result.isProtected() ? ubp.diff(current) : std::vector<std::string>{"protection"};
+        if (changes.empty()) {
+            ++unchanged;
+            continue;
+        }
+
+        if (targets.size() == 1) {
+            cout << "Protections for " << result.repoName << " should become:\n" << ubp.toJSON().dump(2) << endl;
+        }
+        cout << "Changing " << result.repoName << "/" << result.branchName << ":";
+        for (const std::string &key: changes) {
+            cout << " " << key;
+        }
+        cout << endl;
+
+        plan.setProtection(Server::RepositoryName(result.repoName), Server::BranchName(result.branchName), ubp, changes);
+    }
 
-    server.setProtection(orgName, repoName, branchName, ubp);
+    cout << "Unchanged: " << unchanged << ", to change: " << plan.requestCount() << ", failed: " << failed << endl;
+    if (failed > 0) {
+        exitStatus = 1;
+    }
+    carryOut(plan, elapsedSince(started), targets.size());
 }
 
 /**
  * If present, delete this branch's protection.
  */
 void GitTool::deleteBranchProtection() {
-    server.deleteProtection(orgName, repoName, branchName);
+    Clock::time_point started = Clock::now();
+    Plan plan(orgName);
+    for (const auto & [repo, branch]: protectionTargets()) {
+        plan.deleteProtection(repo, branch);
+    }
+    carryOut(plan, elapsedSince(started), 0);
+}
+
+/**
+ * With --plan, save the plan for later. Otherwise make the changes now. reads is how
+ * many requests planning took, from which we guess how long each change will take.
+ */
+void GitTool::carryOut(Plan &plan, double planSeconds, size_t reads) {
+    int workers = server.getBulkWorkers();
+    if (reads > 0) {
+        plan.setSecondsPerRequest(planSeconds * std::min(reads, static_cast<size_t>(workers)) / reads);
+    }
+    plan.setWorkers(workers);
+
+    if (planPath.empty()) {
+        applyPlan(plan);
+        return;
+    }
+
+    cout << std::fixed << std::setprecision(1)
+         << "Plan: " << plan.requestCount() << " requests ("
+         << plan.count(Plan::Action::AddCollaborator) << " collaborator adds, "
+         << plan.count(Plan::Action::SetProtection) << " protection updates, "
+         << plan.count(Plan::Action::DeleteProtection) << " protection deletes), "
+         << "estimated " << plan.estimatedSeconds(workers) << "s with " << workers << " workers. "
+         << "Planned in " << planSeconds << "s." << endl;
+
+    if (!plan.save(planPath)) {
+        Log::error("Couldn't write " + planPath);
+        exitStatus = 1;
+    }
+}
+
+/**
+ * Make the changes and report the failures. Returns how many failed, and any failure
+ * makes the exit status 1.
+ */
+size_t GitTool::applyPlan(const Plan &plan) {
+    Clock::time_point started = Clock::now();
+    std::vector<Plan::Result> results = plan.apply(server);
+
+    size_t failures = 0;
+    for (const Plan::Result &result: results) {
+        if (!result.isSuccess()) {
+            ++failures;
+            Log::error("Failed to " + result.step->describe() + ": " + std::to_string(result.status) + " " + result.message);
+        }
+    }
+    cout << std::fixed << std::setprecision(1)
+         << "Applied " << results.size() - failures << " of " << results.size() << " changes in "
+         << elapsedSince(started) << "s." << endl;
+
+    if (failures > 0) {
+        exitStatus = 1;
+    }
+    return failures;
+}
+
+/**
+ * --apply: carry out a plan written earlier with --plan.
+ */
+void GitTool::applySavedPlan() {
+    Plan plan;
+    try {
+        if (!plan.load(applyPath)) {
+            Log::error("Couldn't read a plan from " + applyPath);
+            exitStatus = 1;
+            return;
+        }
+    }
+    catch (const std::exception &e) {
+        Log::error(applyPath + ": " + e.what());
+        exitStatus = 1;
+        return;
+    }
+
+    cout << std::fixed << std::setprecision(1)
+         << "Applying " << plan.requestCount() << " changes to " << plan.getOrgName()
+         << ", estimated " << plan.estimatedSeconds(server.getBulkWorkers()) << "s." << endl;
+
+    applyPlan(plan);
+}
+
+/**
+ * The repos and branches to audit. A --branch with wildcards is matched against
+ * each repo's branches, which costs a listing per repo. A repo whose branches we
+ * can't list is reported and counted in failures.
+ */
+std::vector<Server::BranchTarget> GitTool::auditTargets(size_t &failures) {
+    Repository::Vector repos = selectRepositories(Repository::IdentityFields | Repository::BranchFields);
+    std::vector<Server::BranchTarget> rv;
+
+    if (!branchGiven) {
+        for (const Repository::Pointer &repo: repos) {
+            if (!repo->default_branch.empty()) {
+                rv.emplace_back(Server::RepositoryName(repo->name), Server::BranchName(repo->default_branch));
+            }
+        }
+        return rv;
+    }
+
+    const string &pattern = branchName.get();
+    if (pattern.find_first_of("*?[") == string::npos) {
+        for (const Repository::Pointer &repo: repos) {
+            rv.emplace_back(Server::RepositoryName(repo->name), branchName);
+        }
+        return rv;
+    }
+
+    std::vector<std::vector<Server::BranchName>> matches(repos.size());
+    std::vector<std::string> errors(repos.size());
+    WorkerPool(server.getBulkWorkers()).run(repos.size(), [&](size_t index) {
+        Tracer::Span span = server.getTracer().span("match branches", "bulk");
+        span.arg("item", index).arg("repo", repos[index]->name);
+
+        try {
+            for (const Server::BranchName &branch: server.getBranchNames(orgName, Server::RepositoryName(repos[index]->name))) {
+                if (fnmatch(pattern.c_str(), branch.get().c_str(), FNM_PATHNAME) == 0) {
+                    matches[index].push_back(branch);
+                }
+            }
+        }
+        catch (const std::exception &e) {
+            errors[index] = e.what();
+        }
+    });
+    for (const std::string &error: errors) {
+        if (!error.empty()) {
+            Log::error(error);
+            ++failures;
+        }
+    }
+    for (size_t index = 0; index < repos.size(); ++index) {
+        for (const Server::BranchName &branch: matches[index]) {
+            rv.emplace_back(Server::RepositoryName(repos[index]->name), branch);
+        }
+    }
+    return rv;
+}
+
+/**
+ * One line of the audit. Unprotected branches only get repo, branch and protected.
+ */
+JSON GitTool::auditEntry(const std::string &repo, const std::string &branch, const BranchProtection *bp) {
+    JSON json = JSON::object();
+    json["repo"] = repo;
+    json["branch"] = branch;
+    json["protected"] = bp != nullptr && bp->getEnabled();
+    if (!json["protected"]) {
+        return json;
+    }
+
+    const RequiredPullRequestReviews &reviews = bp->getRequiredPullRequestReviews();
+    const RequiredStatusChecks &checks = bp->getRequiredStatusChecks();
+
+    if (!bp->getName().empty() && bp->getName() != branch) {
+        json["rule"] = bp->getName();
+    }
+    json["enforce_admins"] = bp->getEnforceAdmins().getEnabled();
+    json["required_reviews"] = reviews.getIsSet() ? reviews.getRequireApprovingReviewCount() : 0;
+    json["dismiss_stale_reviews"] = reviews.getDismissStaleReviews();
+    json["code_owner_reviews"] = reviews.getRequireCodeOwnerReviews();
+    json["status_checks"] = checks.getIsSet() ? checks.getContexts().toJSON() : JSON::array();
+    json["strict_status_checks"] = checks.getStrict();
+    json["restricted_pushes"] = bp->getRestrictions().getIsSet();
+    json["signatures"] = bp->getRequiredSignatures().getEnabled();
+    json["linear_history"] = bp->getRequiredLinearHistory().getEnabled();
+    json["conversation_resolution"] = bp->getRequiredConversationResolution().getEnabled();
+    json["allow_force_pushes"] = bp->getAllowForcePushes().getEnabled();
+    json["allow_deletions"] = bp->getAllowDeletions().getEnabled();
+    json["lock_branch"] = bp->getLockBranch().getEnabled();
+    return json;
+}
+
+/**
+ * Check protection across the org and print one JSON report:
+ *
+ *     {"org":"X","repos":[{"repo":"a","branch":"main","protected":true,...},...],
+ *      "summary":{"branches":N,"protected":P,"unprotected":U,"errors":E}}
+ *
+ * With --graphql the rules come back with the repo listing, 100 repos at a time,
+ * and each branch is checked against them the way GitHub would. Otherwise we read
+ * each branch's protection over REST, --workers at a time. Either way, if anything
+ * failed we still print the report, and exit 1.
+ */
+void GitTool::auditBranchProtection() {
+    if (orgName.get().empty()) {
+        Log::error("Please specify --org.");
+        return;
+    }
+
+    // These are all reads, so we can run more of them at once than the bulk writes.
+    if (!workersGiven) {
+        server.setBulkWorkers(16);
+    }
+
+    JSON entries = JSON::array();
+    size_t protectedCount = 0;
+    size_t errorCount = 0;
+
+    // A failed GraphQL request ends the walk. What we have so far is still worth reporting.
+    string failure;
+
+    if (useGraphQL) {
+        try {
+            server.forEachProtectedRepository(orgName, [&](const Server::ProtectedRepository &item) {
+                const Repository &repo = *item.repository;
+                if (!where.matches(repo)) {
+                    return true;
+                }
+                string branch = branchGiven ? branchName.get() : repo.default_branch;
+                if (branch.empty()) {
+                    return true;
+                }
+                const BranchProtection *bp = item.ruleFor(branch);
+                if (bp != nullptr) {
+                    ++protectedCount;
+                }
+                entries.push_back(auditEntry(repo.name, branch, bp));
+                return true;
+            });
+        }
+        catch (const std::exception &e) {
+            Log::error(e.what());
+            failure = e.what();
+        }
+    }
+    else {
+        size_t listingFailures = 0;
+        std::vector<Server::BranchTarget> targets = auditTargets(listingFailures);
+        if (listingFailures > 0) {
+            failure = std::to_string(listingFailures) + " repos' branches couldn't be listed";
+        }
+
+        for (const Server::ProtectionResult &result: server.getProtections(orgName, targets)) {
+            JSON entry = auditEntry(result.repoName, result.branchName, result.isProtected() ? &result.protection : nullptr);
+            if (result.isProtected()) {
+                ++protectedCount;
+            }
+            else if (result.isError()) {
+                ++errorCount;
+                entry["error"] = result.status > 0
+                    ? std::to_string(result.status) + " " + result.message
+                    : result.message;
+            }
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    JSON summary = JSON::object();
+    summary["branches"] = entries.size();
+    summary["protected"] = protectedCount;
+    summary["unprotected"] = entries.size() - protectedCount - errorCount;
+    summary["errors"] = errorCount + (failure.empty() ? 0 : 1);
+
+    JSON report = JSON::object();
+    report["org"] = orgName.get();
+    report["repos"] = std::move(entries);
+    report["summary"] = summary;
+    if (!failure.empty()) {
+        report["error"] = failure;
+    }
+
+    cout << report.dump() << endl;
+
+    if (errorCount > 0 || !failure.empty()) {
+        exitStatus = 1;
+    }
 }
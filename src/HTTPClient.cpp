@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include <curl/curl.h>
+
+#include <showlib/CommonUsing.h>
+
+#include "HTTPClient.h"
+#include "IOExecutor.h"
+
+using namespace GitTools;
+
+namespace {
+    std::once_flag curlInitFlag;
+
+    size_t writeBody(char *ptr, size_t size, size_t nmemb, void *userdata) {
+        std::string *body = static_cast<std::string *>(userdata);
+        body->append(ptr, size * nmemb);
+        return size * nmemb;
+    }
+
+    /**
+     * Called once per header line. We ignore the status line and keep the rest.
+     */
+    size_t writeHeader(char *ptr, size_t size, size_t nmemb, void *userdata) {
+        HTTPClient::HeaderMap *headers = static_cast<HTTPClient::HeaderMap *>(userdata);
+        string line(ptr, size * nmemb);
+        size_t colon = line.find(':');
+
+        if (colon != string::npos) {
+            string key = line.substr(0, colon);
+            for (char &c: key) {
+                c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            }
+            size_t start = line.find_first_not_of(" \t", colon + 1);
+            size_t end = line.find_last_not_of(" \t\r\n");
+            (*headers)[key] = (start == string::npos || end < start) ? string{} : line.substr(start, end - start + 1);
+        }
+        return size * nmemb;
+    }
+
+    /**
+     * curl reports each phase as the time from the start to its end, so we take the differences.
+     * A transfer that queued for a connection has the queue time in total but not in
+     * the phases, so the caller tells us how long that was.
+     */
+    void readTiming(CURL *curl, double queue, HTTPClient::Timing &timing) {
+        curl_off_t dns = 0, connect = 0, tls = 0, firstByte = 0, total = 0, sent = 0, received = 0;
+        curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+        curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+        curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+        curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &firstByte);
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &sent);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &received);
+
+        // Plain http has no TLS step, and a reused connection has none of the first three.
+        curl_off_t connected = std::max({ dns, connect, tls });
+
+        timing.dns = dns / 1e6;
+        timing.connect = connect > dns ? (connect - dns) / 1e6 : 0.0;
+        timing.tls = tls > connect ? (tls - connect) / 1e6 : 0.0;
+        timing.wait = firstByte > connected ? (firstByte - connected) / 1e6 : 0.0;
+        timing.queue = queue;
+        timing.transfer = std::max((total - firstByte) / 1e6 - queue, 0.0);
+        timing.total = total / 1e6;
+        timing.bytesSent = static_cast<long>(sent);
+        timing.bytesReceived = static_cast<long>(received);
+    }
+}
+
+/**
+ * Return this header's value, or empty if not present.
+ */
+std::string HTTPClient::Response::header(const std::string &name) const {
+    auto it = headers.find(name);
+    return it != headers.end() ? it->second : string{};
+}
+
+/**
+ * Decode the body. Empty or non-JSON bodies come back as null.
+ */
+JSON HTTPClient::Response::json() const {
+    if (body.empty()) {
+        return JSON();
+    }
+    return JSON::parse(body, nullptr, false);
+}
+
+void HTTPClient::setStandardHeader(const std::string &key, const std::string &value) {
+    standardHeaders[key] = value;
+}
+
+void HTTPClient::setAuthentication(const std::string &username, const std::string &password) {
+    userPassword = username + ":" + password;
+}
+
+HTTPClient::Response HTTPClient::get(const std::string &url, const HeaderMap &extraHeaders) {
+    return perform("GET", url, string{}, extraHeaders);
+}
+
+HTTPClient::Response HTTPClient::put(const std::string &url, const JSON &body) {
+    return perform("PUT", url, body.is_null() ? string{} : body.dump(), HeaderMap{});
+}
+
+HTTPClient::Response HTTPClient::post(const std::string &url, const JSON &body) {
+    return perform("POST", url, body.is_null() ? string{} : body.dump(), HeaderMap{});
+}
+
+HTTPClient::Response HTTPClient::del(const std::string &url, const JSON &body) {
+    return perform("DELETE", url, body.is_null() ? string{} : body.dump(), HeaderMap{});
+}
+
+/**
+ * One request's curl handle, with everything the handle points into, which must
+ * outlive it: the header list, the url and the body.
+ */
+class HTTPClient::Transfer {
+public:
+    Transfer(const HTTPClient &client, const std::string &method, const std::string &url, const std::string &body, const HeaderMap &extraHeaders);
+    ~Transfer();
+
+    Transfer(const Transfer &) = delete;
+    Transfer & operator=(const Transfer &) = delete;
+
+    /** Fill in the status and timing, or throw if curl failed. */
+    void finish(CURLcode rv);
+
+    /** For transfers run on an executor, note when they go in and when they leave the queue. */
+    void watchQueue();
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point added;
+    Clock::time_point sending;
+
+    CURL * curl = nullptr;
+    struct curl_slist * headerList = nullptr;
+    std::string method;
+    std::string fullURL;
+    std::string body;
+    Response response;
+};
+
+HTTPClient::Transfer::Transfer(const HTTPClient &client, const std::string &m, const std::string &url, const std::string &b, const HeaderMap &extraHeaders)
+    : method(m), body(b)
+{
+    std::call_once(curlInitFlag, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    curl = curl_easy_init();
+    if (curl == nullptr) {
+        throw std::runtime_error("curl_easy_init failed");
+    }
+
+    for (const auto & [key, value]: client.standardHeaders) {
+        headerList = curl_slist_append(headerList, (key + ": " + value).c_str());
+    }
+    for (const auto & [key, value]: extraHeaders) {
+        headerList = curl_slist_append(headerList, (key + ": " + value).c_str());
+    }
+    if (!body.empty()) {
+        headerList = curl_slist_append(headerList, "Content-Type: application/json");
+    }
+
+    // Almost everything is relative to host, but a few endpoints (GraphQL on GitHub
+    // Enterprise, for instance) live elsewhere on the server.
+    bool absolute = url.compare(0, 7, "http://") == 0 || url.compare(0, 8, "https://") == 0;
+    fullURL = absolute ? url : client.host + url;
+    curl_easy_setopt(curl, CURLOPT_URL, fullURL.c_str());
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerList);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeBody);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, writeHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response.headers);
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+
+    if (!client.userPassword.empty()) {
+        curl_easy_setopt(curl, CURLOPT_USERPWD, client.userPassword.c_str());
+    }
+    if (!body.empty()) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+    }
+}
+
+HTTPClient::Transfer::~Transfer() {
+    curl_slist_free_all(headerList);
+    if (curl != nullptr) {
+        curl_easy_cleanup(curl);
+    }
+}
+
+void HTTPClient::Transfer::finish(CURLcode rv) {
+    if (rv != CURLE_OK) {
+        throw std::runtime_error(method + " " + fullURL + ": " + curl_easy_strerror(rv));
+    }
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+
+    // From going in to being sent is the queue plus connecting, which curl times for us.
+    double queue = 0.0;
+    if (sending > added) {
+        curl_off_t connected = 0;
+        curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &connected);
+        queue = std::max(std::chrono::duration<double>(sending - added).count() - connected / 1e6, 0.0);
+    }
+    readTiming(curl, queue, response.timing);
+}
+
+/**
+ * curl calls this when the request is about to be sent, which is after any wait for a connection.
+ */
+void HTTPClient::Transfer::watchQueue() {
+    added = Clock::now();
+    curl_easy_setopt(curl, CURLOPT_PREREQDATA, this);
+    curl_easy_setopt(curl, CURLOPT_PREREQFUNCTION, +[](void *data, char *, char *, int, int) -> int {
+        Transfer *transfer = static_cast<Transfer *>(data);
+        if (transfer->sending < transfer->added) {
+            transfer->sending = Clock::now();
+        }
+        return CURL_PREREQFUNC_OK;
+    });
+}
+
+/**
+ * Perform a single request. Throws on transport errors; HTTP errors are
+ * reported through the response status.
+ */
+HTTPClient::Response HTTPClient::perform(
+        const std::string &method,
+        const std::string &url,
+        const std::string &body,
+        const HeaderMap &extraHeaders)
+{
+    Transfer transfer(*this, method, url, body, extraHeaders);
+    transfer.finish(curl_easy_perform(transfer.curl));
+    return std::move(transfer.response);
+}
+
+/**
+ * The same, on the executor. We return at once, and done gets the response, or
+ * the exception perform() would have thrown, on the executor's thread.
+ */
+void HTTPClient::performAsync(
+        const std::string &method,
+        const std::string &url,
+        const std::string &body,
+        const HeaderMap &extraHeaders,
+        const Completion &done)
+{
+    std::shared_ptr<Transfer> transfer = std::make_shared<Transfer>(*this, method, url, body, extraHeaders);
+    transfer->watchQueue();
+
+    getExecutor().add(transfer->curl, [transfer, done](int result) {
+        std::exception_ptr error = nullptr;
+        try {
+            transfer->finish(static_cast<CURLcode>(result));
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        done(transfer->response, error);
+    });
+}
+
+IOExecutor & HTTPClient::getExecutor() const {
+    return executor != nullptr ? *executor : IOExecutor::shared();
+}
+
+/**
+ * GitHub's Link header looks like:
+ *
+ *     <https://api.github.com/user/repos?per_page=100&page=2>; rel="next", <...&page=41>; rel="last"
+ *
+ * Return the page number from the rel="last" entry, or 0 if there isn't one.
+ */
+int HTTPClient::lastPageFromLink(const std::string &linkHeader) {
+    size_t relPos = linkHeader.find("rel=\"last\"");
+    if (relPos == string::npos) {
+        return 0;
+    }
+
+    size_t open = linkHeader.rfind('<', relPos);
+    size_t close = linkHeader.find('>', open);
+    if (open == string::npos || close == string::npos || close > relPos) {
+        return 0;
+    }
+
+    string target = linkHeader.substr(open + 1, close - open - 1);
+    size_t pagePos = target.find("?page=");
+    if (pagePos == string::npos) {
+        pagePos = target.find("&page=");
+    }
+    if (pagePos == string::npos) {
+        return 0;
+    }
+
+    return std::atoi(target.c_str() + pagePos + 6);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <map>
+#include <string>
+
+#include <showlib/JSONSerializable.h>
+
+namespace GitTools {
+    class HTTPClient;
+    class IOExecutor;
+}
+
+/**
+ * A thin libcurl wrapper. ShowLib's RESTClient hands us back only the decoded body,
+ * but pagination (and more) depends on the response status and headers, so we
+ * talk to curl directly here.
+ *
+ * Each call uses its own curl handle, so a single HTTPClient may be shared by
+ * multiple threads once it has been configured. performAsync() runs the request
+ * on an IOExecutor instead of the calling thread.
+ */
+class GitTools::HTTPClient
+{
+public:
+    /** Header names are stored lower case. */
+    typedef std::map<std::string, std::string> HeaderMap;
+
+    /**
+     * Where a request's time went, in seconds, and how much it moved. The phases add
+     * up to total. On a reused connection dns, connect and tls are 0.
+     */
+    class Timing {
+    public:
+        /** Waiting for a free connection, for requests run with performAsync(). */
+        double queue = 0.0;
+
+        double dns = 0.0;
+        double connect = 0.0;
+        double tls = 0.0;
+
+        /** From connected to the first byte of the response: sending, plus the server's own time. */
+        double wait = 0.0;
+
+        /** Reading the response. */
+        double transfer = 0.0;
+        double total = 0.0;
+
+        long bytesSent = 0;
+        long bytesReceived = 0;
+    };
+
+    class Response {
+    public:
+        long status = 0;
+        std::string body;
+        HeaderMap headers;
+        Timing timing;
+
+        bool isSuccess() const { return status >= 200 && status < 300; }
+        std::string header(const std::string &name) const;
+        JSON json() const;
+    };
+
+    /** Gets the response, or the exception perform() would have thrown, on the executor's thread. */
+    typedef std::function<void(Response &response, std::exception_ptr error)> Completion;
+
+    void setHost(const std::string &value) { host = value; }
+    const std::string & getHost() const { return host; }
+
+    void setStandardHeader(const std::string &key, const std::string &value);
+    void setAuthentication(const std::string &username, const std::string &password);
+
+    Response get(const std::string &url, const HeaderMap &extraHeaders = HeaderMap{});
+    Response put(const std::string &url, const JSON &body);
+    Response post(const std::string &url, const JSON &body);
+    Response del(const std::string &url, const JSON &body);
+
+    Response perform(const std::string &method, const std::string &url, const std::string &body, const HeaderMap &extraHeaders);
+    void performAsync(const std::string &method, const std::string &url, const std::string &body, const HeaderMap &extraHeaders, const Completion &done);
+
+    /** Where performAsync runs: IOExecutor::shared() unless set. */
+    void setExecutor(IOExecutor *value) { executor = value; }
+    IOExecutor & getExecutor() const;
+
+    static int lastPageFromLink(const std::string &linkHeader);
+
+protected:
+    class Transfer;
+
+    std::string host;
+    std::string userPassword;
+    HeaderMap standardHeaders;
+    IOExecutor * executor = nullptr;
+};
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <curl/curl.h>
+
+#include <showlib/CommonUsing.h>
+
+#include "IOExecutor.h"
+
+using namespace GitTools;
+
+namespace {
+    std::once_flag curlInitFlag;
+
+    /** The longest we sleep in curl_multi_poll with nothing to wake us. */
+    constexpr int MaxPollMillis = 1000;
+}
+
+IOExecutor::IOExecutor() {
+    std::call_once(curlInitFlag, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    multi = curl_multi_init();
+    if (multi == nullptr) {
+        throw std::runtime_error("curl_multi_init failed");
+    }
+}
+
+/**
+ * Stop the thread and drop whatever is still running. Dropping a transfer's Done
+ * breaks any promise it was going to keep.
+ */
+IOExecutor::~IOExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    curl_multi_wakeup(multi);
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    for (auto & [easy, done]: running) {
+        curl_multi_remove_handle(multi, easy);
+    }
+    running.clear();
+    adding.clear();
+    timers.clear();
+    curl_multi_cleanup(multi);
+}
+
+IOExecutor & IOExecutor::shared() {
+    static IOExecutor executor;
+    return executor;
+}
+
+void IOExecutor::post(const Task &task, Clock::duration delay) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        timers.emplace(Clock::now() + delay, task);
+        start();
+    }
+    curl_multi_wakeup(multi);
+}
+
+void IOExecutor::add(void *easyHandle, const Done &done) {
+    ++active;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        adding.emplace_back(easyHandle, done);
+        start();
+    }
+    curl_multi_wakeup(multi);
+}
+
+IOExecutor & IOExecutor::setMaxHostConnections(long value) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxHostConnections = std::max(value, 1L);
+        start();
+    }
+    curl_multi_wakeup(multi);
+    return *this;
+}
+
+/**
+ * Called with the mutex held.
+ */
+void IOExecutor::start() {
+    if (!thread.joinable() && !stopping) {
+        thread = std::thread([this]() { run(); });
+    }
+}
+
+/**
+ * Our thread. Each time round we pick up new transfers and due tasks, let curl do
+ * what it can, finish the transfers that are done, and sleep until there's socket
+ * activity, a wakeup or the next task is due.
+ */
+void IOExecutor::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    long hostConnections = 0;
+
+    while (!stopping) {
+        std::vector<std::pair<void *, Done>> added;
+        added.swap(adding);
+
+        std::vector<Task> due;
+        Clock::time_point now = Clock::now();
+        while (!timers.empty() && timers.begin()->first <= now) {
+            due.push_back(std::move(timers.begin()->second));
+            timers.erase(timers.begin());
+        }
+
+        long wantedConnections = maxHostConnections;
+        lock.unlock();
+
+        if (hostConnections != wantedConnections) {
+            hostConnections = wantedConnections;
+            curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, hostConnections);
+        }
+
+        for (auto & [easy, done]: added) {
+            running.emplace(easy, std::move(done));
+            curl_multi_add_handle(multi, easy);
+        }
+
+        for (Task &task: due) {
+            try {
+                task();
+            }
+            catch (...) {
+                // A task that throws has nobody to tell. Keep the others going.
+            }
+        }
+
+        int stillRunning = 0;
+        curl_multi_perform(multi, &stillRunning);
+
+        int queued = 0;
+        while (CURLMsg *message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL *easy = message->easy_handle;
+            CURLcode result = message->data.result;
+            curl_multi_remove_handle(multi, easy);
+
+            auto it = running.find(easy);
+            if (it == running.end()) {
+                continue;
+            }
+            Done done = std::move(it->second);
+            running.erase(it);
+            --active;
+
+            try {
+                done(static_cast<int>(result));
+            }
+            catch (...) {
+            }
+        }
+
+        lock.lock();
+        if (stopping || !adding.empty() || (!timers.empty() && timers.begin()->first <= Clock::now())) {
+            continue;
+        }
+
+        int timeout = MaxPollMillis;
+        if (!timers.empty()) {
+            auto untilNext = std::chrono::duration_cast<std::chrono::milliseconds>(timers.begin()->first - Clock::now()).count();
+            timeout = static_cast<int>(std::clamp<long long>(untilNext + 1, 0, MaxPollMillis));
+        }
+        lock.unlock();
+
+        curl_multi_poll(multi, nullptr, 0, timeout, nullptr);
+        lock.lock();
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace GitTools {
+    class IOExecutor;
+}
+
+/**
+ * One thread running a curl multi handle, for the asynchronous Server calls. Any
+ * number of transfers can be added from any thread; they share the multi handle's
+ * connections (and HTTP/2 streams, where the server offers them), and their
+ * completions run on the executor's thread. Tasks can be posted to run there too,
+ * now or after a delay, which is how requests wait for the rate limiter without
+ * holding a thread.
+ *
+ * Completions and tasks must not block: anything waiting on a future from here
+ * would wait forever. Decoding a page is fine.
+ *
+ * Most programs use shared(). The thread starts with the first transfer or task,
+ * and transfers still running when the executor is destroyed are dropped.
+ */
+class GitTools::IOExecutor
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<void()> Task;
+
+    /** Called when a transfer finishes, with its CURLcode. */
+    typedef std::function<void(int result)> Done;
+
+    IOExecutor();
+    ~IOExecutor();
+
+    IOExecutor(const IOExecutor &) = delete;
+    IOExecutor & operator=(const IOExecutor &) = delete;
+
+    static IOExecutor & shared();
+
+    /** Run the task on our thread, after this long. */
+    void post(const Task &task, Clock::duration delay = Clock::duration::zero());
+
+    /**
+     * Run this curl easy handle. It's removed from the multi handle before done is
+     * called, and done (or whatever it holds) is responsible for cleaning it up.
+     */
+    void add(void *easyHandle, const Done &done);
+
+    /** Transfers added and not yet done. */
+    size_t getActive() const { return active; }
+
+    /** Connections per host. More transfers than this queue, or share one over HTTP/2. */
+    IOExecutor & setMaxHostConnections(long value);
+
+protected:
+    void start();
+    void run();
+
+    void * multi = nullptr;
+    std::thread thread;
+
+    mutable std::mutex mutex;
+    std::vector<std::pair<void *, Done>> adding;
+    std::multimap<Clock::time_point, Task> timers;
+    long maxHostConnections = 8;
+    bool stopping = false;
+
+    /** Only touched by our thread. */
+    std::unordered_map<void *, Done> running;
+    std::atomic<size_t> active { 0 };
+};
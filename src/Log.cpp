@@ -0,0 +1,134 @@
+#include <iostream>
+#include <stdexcept>
+
+#include <showlib/CommonUsing.h>
+#include <showlib/StringUtils.h>
+
+#include "Log.h"
+
+using namespace GitTools;
+
+namespace {
+    const char * const levelNames[] = { "debug", "info", "warning", "error", "off" };
+}
+
+Log::Log()
+    : sink(writeToStderr)
+{
+    string name = ShowLib::getEnv("GIT_LOG_LEVEL");
+    if (!name.empty()) {
+        try {
+            level = levelNamed(name);
+        }
+        catch (const std::invalid_argument &) {
+        }
+    }
+}
+
+/**
+ * Write whatever is still queued, then stop the thread.
+ */
+Log::~Log() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+Log & Log::instance() {
+    static Log log;
+    return log;
+}
+
+Log & Log::setSink(const Sink &value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sink = value != nullptr ? value : Sink(writeToStderr);
+    return *this;
+}
+
+/**
+ * Queue the message. The thread starts with the first one, so a program that
+ * never logs never has it.
+ */
+void Log::write(Level messageLevel, const std::string &message) {
+    if (!isEnabled(messageLevel)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.emplace_back(messageLevel, message);
+        if (!thread.joinable()) {
+            thread = std::thread([this]() { drain(); });
+        }
+    }
+    wake.notify_one();
+}
+
+void Log::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return queue.empty() && !writing; });
+}
+
+/**
+ * The logging thread. We take everything queued at once and write it without
+ * the lock, so writers only wait for each other, never for the sink.
+ */
+void Log::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wake.wait(lock, [this]() { return !queue.empty() || stopping; });
+        if (queue.empty()) {
+            break;
+        }
+
+        std::deque<std::pair<Level, string>> batch;
+        batch.swap(queue);
+        Sink current = sink;
+        writing = true;
+        lock.unlock();
+
+        for (const auto & [messageLevel, message]: batch) {
+            try {
+                current(messageLevel, message);
+            }
+            catch (...) {
+                // A broken sink mustn't take the program down with it.
+            }
+        }
+
+        lock.lock();
+        writing = false;
+        if (queue.empty()) {
+            idle.notify_all();
+        }
+    }
+}
+
+const char * Log::nameOf(Level value) {
+    return levelNames[static_cast<int>(value)];
+}
+
+Log::Level Log::levelNamed(const std::string &name) {
+    string lower = ShowLib::toLower(ShowLib::trim(name));
+    for (int index = 0; index <= static_cast<int>(Level::Off); ++index) {
+        if (lower == levelNames[index]) {
+            return static_cast<Level>(index);
+        }
+    }
+    throw std::invalid_argument("Unknown log level: " + name + ". Use debug, info, warning, error or off.");
+}
+
+void Log::writeToStderr(Level messageLevel, const std::string &message) {
+    if (messageLevel == Level::Info) {
+        std::cerr << message << "\n";
+    }
+    else {
+        std::cerr << nameOf(messageLevel) << ": " << message << "\n";
+    }
+}
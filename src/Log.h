@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace GitTools {
+    class Log;
+}
+
+/**
+ * Where Server and GitTool send their diagnostics, so stdout carries only results.
+ * Messages below the level are dropped; the rest are queued and handed to the sink
+ * by a background thread, so callers never wait on the output stream. The default
+ * sink writes to stderr, prefixing anything but info with its level.
+ *
+ *     Log::instance().setLevel(Log::Level::Warning);
+ *     Log::instance().setSink([](Log::Level level, const std::string &message) { myLogger(message); });
+ *     Log::instance().setLevel(Log::Level::Off);      // Silence the library
+ *
+ * The level starts as $GIT_LOG_LEVEL (debug, info, warning, error or off), or info.
+ * Messages still queued at exit are written before the thread stops.
+ */
+class GitTools::Log
+{
+public:
+    enum class Level { Debug, Info, Warning, Error, Off };
+
+    /** Called on the logging thread, one message at a time. */
+    typedef std::function<void(Level level, const std::string &message)> Sink;
+
+    Log();
+    ~Log();
+
+    Log(const Log &) = delete;
+    Log & operator=(const Log &) = delete;
+
+    /** The log the library writes to. */
+    static Log & instance();
+
+    static void debug(const std::string &message) { instance().write(Level::Debug, message); }
+    static void info(const std::string &message) { instance().write(Level::Info, message); }
+    static void warning(const std::string &message) { instance().write(Level::Warning, message); }
+    static void error(const std::string &message) { instance().write(Level::Error, message); }
+
+    Log & setLevel(Level value) { level = value; return *this; }
+    Level getLevel() const { return level; }
+    bool isEnabled(Level value) const { return value >= level && value != Level::Off; }
+
+    /** Send messages here instead. A null sink goes back to stderr. */
+    Log & setSink(const Sink &value);
+
+    void write(Level messageLevel, const std::string &message);
+
+    /** Wait until everything written so far has reached the sink. */
+    void flush();
+
+    static const char * nameOf(Level value);
+
+    /** "warning" to Level::Warning. Throws std::invalid_argument for a name we don't know. */
+    static Level levelNamed(const std::string &name);
+
+    static void writeToStderr(Level messageLevel, const std::string &message);
+
+protected:
+    void drain();
+
+    std::atomic<Level> level { Level::Info };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<std::pair<Level, std::string>> queue;
+    Sink sink;
+    std::thread thread;
+    bool writing = false;
+    bool stopping = false;
+};
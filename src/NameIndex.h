@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cctype>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "PackedVector.h"
+
+namespace GitTools {
+    template <class T> class NameIndex;
+}
+
+/**
+ * A case-insensitive lookup by name over one of our vectors. Build it once after a
+ * fetch; lookups are then a hash probe rather than a findIf scan. The index holds
+ * the same shared pointers as the vector, so it stays valid if the vector goes away.
+ *
+ *     Repository::Index index(repos, Repository::indexByName);
+ *     Repository::Pointer repo = index.find("Hello-World");
+ */
+template <class T>
+class GitTools::NameIndex
+{
+public:
+    typedef typename T::Pointer Pointer;
+    typedef typename T::Vector Vector;
+    typedef std::function<const std::string &(const T &)> KeyFunction;
+
+    NameIndex() = default;
+
+    NameIndex(const Vector &vec, const KeyFunction &keyFunction) {
+        build(vec, keyFunction);
+    }
+
+    /**
+     * (Re)build from this vector. If two entries differ only in case, the first wins.
+     */
+    void build(const Vector &vec, const KeyFunction &keyFunction) {
+        map.clear();
+        map.reserve(vec.size());
+        for (const Pointer &ptr: vec) {
+            map.emplace(fold(keyFunction(*ptr)), ptr);
+        }
+    }
+
+    /**
+     * Build from a PackedVector. The index then shares ownership of its arena.
+     */
+    void build(const PackedVector<T> &vec, const KeyFunction &keyFunction) {
+        map.clear();
+        map.reserve(vec.size());
+        for (size_t index = 0; index < vec.size(); ++index) {
+            map.emplace(fold(keyFunction(vec[index])), vec.pointerAt(index));
+        }
+    }
+
+    /** Find this name, ignoring case. Returns nullptr if not found. */
+    Pointer find(const std::string &name) const {
+        auto it = map.find(fold(name));
+        return it != map.end() ? it->second : nullptr;
+    }
+
+    bool contains(const std::string &name) const { return map.count(fold(name)) > 0; }
+    size_t size() const { return map.size(); }
+    bool empty() const { return map.empty(); }
+
+    static std::string fold(const std::string &name) {
+        std::string rv = name;
+        for (char &c: rv) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return rv;
+    }
+
+protected:
+    std::unordered_map<std::string, Pointer> map;
+};
@@ -0,0 +1,188 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include <unistd.h>
+
+#include <showlib/CommonUsing.h>
+#include <showlib/StringUtils.h>
+
+#include "OrgSnapshot.h"
+
+using namespace GitTools;
+
+namespace {
+    time_t timeValue(const JSON &json, const std::string &key) {
+        return ShowLib::JSONSerializable::hasKey(json, key) && json[key].is_number() ? json[key].get<time_t>() : 0;
+    }
+}
+
+OrgSnapshot::OrgSnapshot(const Server::OwnerName &name)
+    : orgName(name.get())
+{
+}
+
+/**
+ * Snapshots live in GIT_SNAPSHOT_DIR, or ~/.gittools/snapshots.
+ */
+std::string OrgSnapshot::defaultDirectory() {
+    string dir = ShowLib::getEnv("GIT_SNAPSHOT_DIR");
+    if (dir.empty()) {
+        dir = ShowLib::getEnv("HOME", ".") + "/.gittools/snapshots";
+    }
+    return dir;
+}
+
+std::string OrgSnapshot::getPath() const {
+    return directory + "/" + orgName + ".json";
+}
+
+bool OrgSnapshot::isFresh(time_t maxAge) const {
+    return syncedAt > 0 && time(nullptr) - syncedAt <= maxAge;
+}
+
+/**
+ * Read from JSON.
+ */
+void OrgSnapshot::fromJSON(const JSON &json) {
+    orgName = stringValue(json, "org");
+    syncedAt = timeValue(json, "synced_at");
+    fullSyncAt = timeValue(json, "full_sync_at");
+    reposUpdatedAt = stringValue(json, "repos_updated_at");
+
+    repos.clear();
+    teams.clear();
+    users.clear();
+
+    repos.fromJSON(jsonArray(json, "repositories"));
+    teams.fromJSON(jsonArray(json, "teams"));
+    users.fromJSON(jsonArray(json, "users"));
+}
+
+/**
+ * Output to JSON.
+ */
+JSON OrgSnapshot::toJSON() const {
+    JSON json = JSON::object();
+
+    json["org"] = orgName;
+    json["synced_at"] = syncedAt;
+    json["full_sync_at"] = fullSyncAt;
+    json["repos_updated_at"] = reposUpdatedAt;
+    json["repositories"] = repos.toJSON();
+    json["teams"] = teams.toJSON();
+    json["users"] = users.toJSON();
+
+    return json;
+}
+
+/**
+ * Load from disk. Returns false if there's no usable snapshot.
+ */
+bool OrgSnapshot::load() {
+    std::ifstream input(getPath());
+    if (!input) {
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+
+    JSON json = JSON::parse(buffer.str(), nullptr, false);
+    if (!json.is_object() || stringValue(json, "org") != orgName) {
+        return false;
+    }
+
+    fromJSON(json);
+    return true;
+}
+
+/**
+ * Write to disk. We write a temporary file and rename it into place so a
+ * concurrent reader never sees half a snapshot.
+ */
+bool OrgSnapshot::save() const {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    string path = getPath();
+    string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream output(tmpPath, std::ios::trunc);
+        if (!output) {
+            return false;
+        }
+        output << toJSON().dump();
+        if (!output) {
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, error);
+    if (error) {
+        std::filesystem::remove(tmpPath, error);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Bring the snapshot up to date. The caller decides whether to save() it.
+ */
+void OrgSnapshot::sync(Server &server, bool full) {
+    time_t now = time(nullptr);
+    Server::OwnerName owner(orgName);
+
+    bool incremental = !full
+        && !reposUpdatedAt.empty()
+        && now - fullSyncAt < fullSyncAge;
+
+    if (incremental) {
+        std::unordered_map<int, size_t> positions;
+        for (size_t index = 0; index < repos.size(); ++index) {
+            positions[repos[index]->id] = index;
+        }
+
+        string newest = reposUpdatedAt;
+
+        // ISO 8601 UTC times compare correctly as strings. Repos updated in the same
+        // second as our mark are read again, as we can't tell if we saw them.
+        server.repositories(owner).forEach([&](const Repository::Pointer &repo) {
+            if (repo->updated_at < reposUpdatedAt) {
+                return false;
+            }
+
+            auto it = positions.find(repo->id);
+            if (it != positions.end()) {
+                repos[it->second] = repo;
+            }
+            else {
+                positions[repo->id] = repos.size();
+                repos.push_back(repo);
+            }
+
+            if (repo->updated_at > newest) {
+                newest = repo->updated_at;
+            }
+            return true;
+        });
+
+        reposUpdatedAt = newest;
+    }
+    else {
+        repos = server.getRepositories(owner);
+        fullSyncAt = now;
+
+        reposUpdatedAt.clear();
+        for (const Repository::Pointer &repo: repos) {
+            if (repo->updated_at > reposUpdatedAt) {
+                reposUpdatedAt = repo->updated_at;
+            }
+        }
+    }
+
+    teams = server.getTeams(owner);
+    users = server.getUsers(owner);
+    syncedAt = now;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <ctime>
+#include <string>
+
+#include <showlib/JSONSerializable.h>
+
+#include "Server.h"
+
+namespace GitTools {
+    class OrgSnapshot;
+}
+
+/**
+ * A local copy of an org's repos, teams and members, so that tools run many times an
+ * hour don't each fetch everything again.
+ *
+ * sync() brings it up to date. Repos are read newest-update-first and we stop as soon
+ * as we reach ones we already have, so a sync of a quiet org is usually one page.
+ * An incremental sync can't see deleted repos; a full sync (or one older than
+ * fullSyncAge) starts over. Teams and members have no update time to sort by, so
+ * they are always read in full -- with a response cache they're mostly 304s.
+ */
+class GitTools::OrgSnapshot: public ShowLib::JSONSerializable
+{
+public:
+    OrgSnapshot() = default;
+    OrgSnapshot(const Server::OwnerName &orgName);
+
+    void fromJSON(const JSON &) override;
+    JSON toJSON() const override;
+
+    bool load();
+    bool save() const;
+    void sync(Server &server, bool full = false);
+
+    /** Was this synced within the last maxAge seconds? */
+    bool isFresh(time_t maxAge) const;
+
+    static std::string defaultDirectory();
+    std::string getPath() const;
+
+    const std::string & getOrgName() const { return orgName; }
+    time_t getSyncedAt() const { return syncedAt; }
+    time_t getFullSyncAt() const { return fullSyncAt; }
+
+    const Repository::Vector & getRepositories() const { return repos; }
+    const Team::Vector & getTeams() const { return teams; }
+    const User::Vector & getUsers() const { return users; }
+
+    OrgSnapshot & setDirectory(const std::string &value) { directory = value; return *this; }
+
+    /** An incremental sync older than this many seconds becomes a full one. */
+    static constexpr time_t fullSyncAge = 24 * 60 * 60;
+
+protected:
+    std::string directory = defaultDirectory();
+    std::string orgName;
+
+    /** Local time of the last sync. */
+    time_t syncedAt = 0;
+    time_t fullSyncAt = 0;
+
+    /** The newest updated_at we've seen, in the server's own ISO 8601 form. */
+    std::string reposUpdatedAt;
+
+    Repository::Vector repos;
+    Team::Vector teams;
+    User::Vector users;
+};
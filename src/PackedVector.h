@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <showlib/JSONSerializable.h>
+
+namespace GitTools {
+    template <class T> class PackedVector;
+}
+
+/**
+ * An alternative to T::Vector for big listings. T::Vector holds a shared_ptr per
+ * element, which is a heap allocation and a control block per object and a pointer
+ * to chase on every step of a loop. A PackedVector stores the objects themselves, in
+ * chunks that hold chunkSize objects side by side, all owned by one arena.
+ *
+ * Objects never move once added, so references stay good as the vector grows. Range-for
+ * and findIf work as they do with T::Vector, except you get T rather than T::Pointer:
+ *
+ *     Repository::Packed repos;
+ *     server.repositories(orgName).collect(repos);
+ *     for (const Repository &repo: repos) { ... }
+ *     const Repository *found = repos.findIf([](const Repository &repo) { return repo.archived; });
+ *
+ * If something needs a T::Pointer, pointerAt() hands out one that shares ownership of
+ * the whole arena rather than allocating anything.
+ */
+template <class T>
+class GitTools::PackedVector
+{
+protected:
+    /** The storage. Shared so that pointerAt() can keep it alive. */
+    class Arena {
+    public:
+        Arena(size_t chunkSize): chunkSize(chunkSize) {}
+        Arena(const Arena &) = delete;
+        Arena & operator=(const Arena &) = delete;
+
+        ~Arena() {
+            for (size_t index = count; index > 0; --index) {
+                at(index - 1).~T();
+            }
+            for (T *chunk: chunks) {
+                ::operator delete(chunk, std::align_val_t(alignof(T)));
+            }
+        }
+
+        T & at(size_t index) const { return chunks[index / chunkSize][index % chunkSize]; }
+
+        T & add() {
+            if (count == chunks.size() * chunkSize) {
+                void *memory = ::operator new(sizeof(T) * chunkSize, std::align_val_t(alignof(T)));
+                chunks.push_back(static_cast<T *>(memory));
+            }
+            T *slot = &chunks.back()[count % chunkSize];
+            new (slot) T();
+            ++count;
+            return *slot;
+        }
+
+        size_t chunkSize;
+        size_t count = 0;
+        std::vector<T *> chunks;
+    };
+
+    template <class Vec, class Value>
+    class Iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Value value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Value * pointer;
+        typedef Value & reference;
+
+        Iterator(Vec *vec, size_t index): vec(vec), index(index) {}
+
+        reference operator*() const { return (*vec)[index]; }
+        pointer operator->() const { return &(*vec)[index]; }
+        Iterator & operator++() { ++index; return *this; }
+        Iterator operator++(int) { Iterator rv = *this; ++index; return rv; }
+        bool operator==(const Iterator &other) const { return index == other.index; }
+        bool operator!=(const Iterator &other) const { return index != other.index; }
+
+    protected:
+        Vec *vec;
+        size_t index;
+    };
+
+public:
+    typedef typename T::Pointer Pointer;
+    typedef Iterator<PackedVector, T> iterator;
+    typedef Iterator<const PackedVector, const T> const_iterator;
+
+    /** The default matches GitHub's largest page, so a page lands in a single chunk. */
+    explicit PackedVector(size_t chunkSize = 100)
+        : chunkSize(chunkSize > 0 ? chunkSize : 1), arena(std::make_shared<Arena>(this->chunkSize)) {}
+
+    /** Moving takes the arena and leaves the other one empty but usable. */
+    PackedVector(PackedVector &&other): chunkSize(other.chunkSize), arena(std::move(other.arena)) {
+        other.clear();
+    }
+
+    PackedVector & operator=(PackedVector &&other) {
+        chunkSize = other.chunkSize;
+        arena = std::move(other.arena);
+        other.clear();
+        return *this;
+    }
+
+    PackedVector(const PackedVector &) = delete;
+    PackedVector & operator=(const PackedVector &) = delete;
+
+    /** Add a default-constructed T and return it for filling in. */
+    T & add() { return arena->add(); }
+
+    size_t size() const { return arena->count; }
+    bool empty() const { return arena->count == 0; }
+
+    T & operator[](size_t index) { return arena->at(index); }
+    const T & operator[](size_t index) const { return arena->at(index); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    /** The first object that matches, or nullptr. */
+    const T * findIf(const std::function<bool(const T &)> &f) const {
+        for (const T &obj: *this) {
+            if (f(obj)) {
+                return &obj;
+            }
+        }
+        return nullptr;
+    }
+
+    /** A T::Pointer to this element. It keeps the whole arena alive. */
+    Pointer pointerAt(size_t index) const { return Pointer(arena, &arena->at(index)); }
+
+    /**
+     * Let go of everything. Pointers from pointerAt() still hold the old arena.
+     */
+    void clear() { arena = std::make_shared<Arena>(chunkSize); }
+
+    JSON toJSON() const {
+        JSON json = JSON::array();
+        for (const T &obj: *this) {
+            json.push_back(obj.toJSON());
+        }
+        return json;
+    }
+
+protected:
+    size_t chunkSize;
+    std::shared_ptr<Arena> arena;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "StreamDecoder.h"
+
+namespace GitTools {
+    template <class T> class Paginated;
+}
+
+/**
+ * A paginated listing of T (Repository, Team, User, ...). Nothing is fetched until
+ * you walk it, and then each page is decoded and handed to you as soon as it arrives,
+ * in page order. Pages are decoded with StreamDecoder, straight from the response body
+ * into T, without building a JSON DOM along the way. Only the page being delivered
+ * (plus any the server is reading ahead) is held in memory, unless you call collect().
+ *
+ * Callbacks return true to keep going or false to stop early. A page that fails to
+ * decode throws std::runtime_error rather than cutting the listing short.
+ *
+ *     server.repositories().forEach([](const Repository::Pointer &repo) {
+ *         cout << repo->name << endl;
+ *         return true;
+ *     });
+ */
+template <class T>
+class GitTools::Paginated
+{
+public:
+    typedef typename T::Pointer Pointer;
+    typedef typename T::Vector Vector;
+
+    typedef std::function<bool(std::string &)> BodyCallback;
+    typedef std::function<void(const BodyCallback &)> PageSource;
+    typedef std::function<bool(const Vector &)> PageCallback;
+    typedef std::function<bool(const Pointer &)> ItemCallback;
+
+    /** Called on each new object before it's decoded. */
+    typedef typename StreamDecoder<T>::Prepare Prepare;
+
+    Paginated(PageSource source, Prepare prepare = nullptr): source(source), prepare(prepare) {}
+
+    /**
+     * Hand each page to the callback as it's decoded.
+     */
+    void forEachPage(const PageCallback &callback) const {
+        source([&](std::string &body) {
+            Vector page;
+            StreamDecoder<T> decoder(page, prepare);
+            decoder.decode(body);
+
+            // Let go of the body before the caller starts working.
+            std::string().swap(body);
+            return callback(page);
+        });
+    }
+
+    /**
+     * Hand each object to the callback as its page is decoded.
+     */
+    void forEach(const ItemCallback &callback) const {
+        forEachPage([&](const Vector &page) {
+            for (const Pointer &ptr: page) {
+                if (!callback(ptr)) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    /**
+     * Read the entire listing into a single vector.
+     */
+    Vector collect() const {
+        Vector vec;
+        forEachPage([&](const Vector &page) {
+            vec.insert(vec.end(), page.begin(), page.end());
+            return true;
+        });
+        return vec;
+    }
+
+    /**
+     * Read the entire listing into a PackedVector, which avoids an allocation per object.
+     */
+    void collect(PackedVector<T> &vec) const {
+        source([&](std::string &body) {
+            PackedDecoder<T> decoder(vec, prepare);
+            decoder.decode(body);
+            return true;
+        });
+    }
+
+protected:
+    PageSource source;
+    Prepare prepare;
+};
@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <showlib/CommonUsing.h>
+
+#include "Plan.h"
+
+using namespace GitTools;
+
+namespace {
+    struct ActionName {
+        Plan::Action action;
+        const char *name;
+    };
+
+    const ActionName actionNames[] = {
+        { Plan::Action::AddCollaborator,  "add_collaborator" },
+        { Plan::Action::SetProtection,    "set_protection" },
+        { Plan::Action::DeleteProtection, "delete_protection" },
+    };
+
+    const char * nameOf(Plan::Action action) {
+        for (const ActionName &entry: actionNames) {
+            if (entry.action == action) {
+                return entry.name;
+            }
+        }
+        return "";
+    }
+
+    double doubleValue(const JSON &json, const std::string &key) {
+        return ShowLib::JSONSerializable::hasKey(json, key) && json[key].is_number() ? json[key].get<double>() : 0.0;
+    }
+}
+
+//======================================================================
+// Steps.
+//======================================================================
+
+/**
+ * Output to JSON.
+ */
+JSON Plan::Step::toJSON() const {
+    JSON json = JSON::object();
+
+    json["action"] = nameOf(action);
+    json["repo"] = repoName;
+    setStringValue(json, "branch", branchName);
+    setStringValue(json, "login", login);
+    setStringValue(json, "permission", permission);
+    if (action == Action::SetProtection) {
+        json["changes"] = changes;
+        json["body"] = body;
+    }
+
+    return json;
+}
+
+/**
+ * Read from JSON. An action we don't know throws, as we'd rather not apply part of a plan.
+ */
+void Plan::Step::fromJSON(const JSON &json) {
+    string name = stringValue(json, "action");
+    bool found = false;
+    for (const ActionName &entry: actionNames) {
+        if (name == entry.name) {
+            action = entry.action;
+            found = true;
+        }
+    }
+    if (!found) {
+        throw std::runtime_error("Unknown plan action: " + name);
+    }
+
+    repoName = stringValue(json, "repo");
+    branchName = stringValue(json, "branch");
+    login = stringValue(json, "login");
+    permission = stringValue(json, "permission");
+
+    changes.clear();
+    for (const JSON &change: jsonArray(json, "changes")) {
+        changes.push_back(change.is_string() ? change.get<string>() : string{});
+    }
+    body = jsonValue(json, "body");
+}
+
+std::string Plan::Step::describe() const {
+    switch (action) {
+        case Action::AddCollaborator:  return "add " + login + " to " + repoName + " (" + permission + ")";
+        case Action::SetProtection:    return "set protection on " + repoName + "/" + branchName;
+        case Action::DeleteProtection: return "delete protection on " + repoName + "/" + branchName;
+    }
+    return "";
+}
+
+//======================================================================
+// The plan.
+//======================================================================
+
+Plan::Plan(const Server::OwnerName &name)
+    : orgName(name.get())
+{
+}
+
+/**
+ * Output to JSON. The counts and estimate are for whoever reviews the file;
+ * fromJSON works them out again.
+ */
+JSON Plan::toJSON() const {
+    JSON json = JSON::object();
+
+    json["org"] = orgName;
+    json["created_at"] = time(nullptr);
+    json["requests"] = requestCount();
+    json["collaborator_adds"] = count(Action::AddCollaborator);
+    json["protection_updates"] = count(Action::SetProtection);
+    json["protection_deletes"] = count(Action::DeleteProtection);
+    json["workers"] = workers;
+    json["seconds_per_request"] = secondsPerRequest;
+    json["estimated_seconds"] = estimatedSeconds(workers);
+    json["steps"] = steps.toJSON();
+
+    return json;
+}
+
+/**
+ * Read from JSON.
+ */
+void Plan::fromJSON(const JSON &json) {
+    orgName = stringValue(json, "org");
+    setWorkers(intValue(json, "workers"));
+    setSecondsPerRequest(doubleValue(json, "seconds_per_request"));
+
+    steps.clear();
+    steps.fromJSON(jsonArray(json, "steps"));
+}
+
+/**
+ * Load from disk. Returns false if the file is missing or isn't a plan.
+ */
+bool Plan::load(const std::string &path) {
+    std::ifstream input(path);
+    if (!input) {
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+
+    JSON json = JSON::parse(buffer.str(), nullptr, false);
+    if (!json.is_object() || !hasKey(json, "steps")) {
+        return false;
+    }
+
+    fromJSON(json);
+    return true;
+}
+
+/**
+ * Write to disk, by way of a temporary file so nobody applies half a plan.
+ */
+bool Plan::save(const std::string &path) const {
+    string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream output(tmpPath, std::ios::trunc);
+        if (!output) {
+            return false;
+        }
+        output << toJSON().dump(2) << "\n";
+        if (!output) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmpPath, path, error);
+    if (error) {
+        std::filesystem::remove(tmpPath, error);
+        return false;
+    }
+    return true;
+}
+
+void Plan::addCollaborator(const Server::RepositoryName &repoName, const Server::UserName &login, const Server::PermissionName &perm) {
+    Step::Pointer step = std::make_shared<Step>();
+    step->action = Action::AddCollaborator;
+    step->repoName = repoName.get();
+    step->login = login.get();
+    step->permission = perm.get();
+    steps.push_back(step);
+}
+
+void Plan::setProtection(const Server::RepositoryName &repoName, const Server::BranchName &branchName,
+    const UpdateBranchProtection &protection, const std::vector<std::string> &changes)
+{
+    Step::Pointer step = std::make_shared<Step>();
+    step->action = Action::SetProtection;
+    step->repoName = repoName.get();
+    step->branchName = branchName.get();
+    step->changes = changes;
+    step->body = protection.toJSON();
+    steps.push_back(step);
+}
+
+void Plan::deleteProtection(const Server::RepositoryName &repoName, const Server::BranchName &branchName) {
+    Step::Pointer step = std::make_shared<Step>();
+    step->action = Action::DeleteProtection;
+    step->repoName = repoName.get();
+    step->branchName = branchName.get();
+    steps.push_back(step);
+}
+
+size_t Plan::count(Action action) const {
+    size_t rv = 0;
+    for (const Step::Pointer &step: steps) {
+        if (step->action == action) {
+            ++rv;
+        }
+    }
+    return rv;
+}
+
+/**
+ * The requests go out in rounds of workers at a time. This ignores the rate
+ * limiter, which only matters once a plan is bigger than the remaining budget.
+ */
+double Plan::estimatedSeconds(int workerCount) const {
+    size_t perRound = static_cast<size_t>(std::max(workerCount, 1));
+    size_t rounds = (steps.size() + perRound - 1) / perRound;
+    return static_cast<double>(rounds) * secondsPerRequest;
+}
+
+/**
+ * The steps go to the server's bulk calls: the collaborator adds one call per login
+ * and permission, then the protection updates, then the deletes. Each call runs
+ * server.getBulkWorkers() requests at a time. A step that fails doesn't stop the
+ * rest; it's reported in its Result.
+ */
+std::vector<Plan::Result> Plan::apply(Server &server) const {
+    std::vector<Result> results(steps.size());
+    Server::OwnerName org(orgName);
+
+    // Collaborator adds, grouped by login and permission in the order they first appear.
+    std::vector<std::vector<size_t>> adds;
+    std::map<std::pair<string, string>, size_t> addGroups;
+
+    std::vector<size_t> sets;
+    std::vector<size_t> deletes;
+
+    for (size_t index = 0; index < steps.size(); ++index) {
+        const Step &step = *steps[index];
+        results[index].step = steps[index];
+
+        switch (step.action) {
+            case Action::AddCollaborator: {
+                auto [it, added] = addGroups.try_emplace(std::make_pair(step.login, step.permission), adds.size());
+                if (added) {
+                    adds.emplace_back();
+                }
+                adds[it->second].push_back(index);
+                break;
+            }
+            case Action::SetProtection:    sets.push_back(index); break;
+            case Action::DeleteProtection: deletes.push_back(index); break;
+        }
+    }
+
+    for (const std::vector<size_t> &group: adds) {
+        const Step &first = *steps[group.front()];
+        std::vector<Server::RepositoryName> repoNames;
+        for (size_t index: group) {
+            repoNames.push_back(Server::RepositoryName(steps[index]->repoName));
+        }
+
+        std::vector<Server::CollaboratorResult> added = server.addUsersToRepos(org, repoNames,
+            { Server::UserName(first.login) }, Server::PermissionName(first.permission));
+        for (size_t item = 0; item < group.size(); ++item) {
+            results[group[item]].status = added[item].status;
+            results[group[item]].message = added[item].message;
+        }
+    }
+
+    auto targetsOf = [this](const std::vector<size_t> &indexes) {
+        std::vector<Server::BranchTarget> targets;
+        for (size_t index: indexes) {
+            targets.emplace_back(Server::RepositoryName(steps[index]->repoName), Server::BranchName(steps[index]->branchName));
+        }
+        return targets;
+    };
+    auto record = [&results](const std::vector<size_t> &indexes, const std::vector<Server::ProtectionResult> &outcomes) {
+        for (size_t item = 0; item < indexes.size(); ++item) {
+            results[indexes[item]].status = outcomes[item].status;
+            results[indexes[item]].message = outcomes[item].message;
+        }
+    };
+
+    if (!sets.empty()) {
+        std::vector<JSON> bodies;
+        for (size_t index: sets) {
+            bodies.push_back(steps[index]->body);
+        }
+        record(sets, server.setProtections(org, targetsOf(sets), bodies));
+    }
+
+    if (!deletes.empty()) {
+        record(deletes, server.deleteProtections(org, targetsOf(deletes)));
+    }
+
+    return results;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <showlib/JSONSerializable.h>
+
+#include "Server.h"
+
+namespace GitTools {
+    class Plan;
+}
+
+/**
+ * A list of changes to make to an org, worked out ahead of time so it can be
+ * reviewed, saved, and carried out later:
+ *
+ *     Plan plan(orgName);
+ *     plan.addCollaborator(repoName, login, permName);
+ *     plan.save("changes.json");
+ *     ...
+ *     Plan later;
+ *     later.load("changes.json");
+ *     for (const Plan::Result &result: later.apply(server)) { ... }
+ *
+ * Each step is one request. The file holds the request count and an estimate
+ * of how long apply() will take, based on how quick the server was while we
+ * were planning.
+ */
+class GitTools::Plan: public ShowLib::JSONSerializable
+{
+public:
+    enum class Action { AddCollaborator, SetProtection, DeleteProtection };
+
+    /** One request. Only the fields its action needs are filled in. */
+    class Step: public ShowLib::JSONSerializable {
+    public:
+        typedef std::shared_ptr<Step> Pointer;
+        typedef ShowLib::JSONSerializableVector<Step> Vector;
+
+        JSON toJSON() const override;
+        void fromJSON(const JSON &) override;
+
+        /** Something like "set protection on foo/main". */
+        std::string describe() const;
+
+        Action action = Action::AddCollaborator;
+        std::string repoName;
+        std::string branchName;
+        std::string login;
+        std::string permission;
+
+        /** For SetProtection, the keys that change (see UpdateBranchProtection::diff). */
+        std::vector<std::string> changes;
+
+        /** For SetProtection, the PUT body. */
+        JSON body;
+    };
+
+    /** The outcome of one step of apply(). */
+    class Result {
+    public:
+        Step::Pointer step;
+        long status = 0;
+        std::string message;
+
+        /** Deleting the protection of a branch that has none is already done: GitHub answers 404 "Branch not protected". */
+        bool isSuccess() const {
+            return (status >= 200 && status < 300)
+                || (step && step->action == Action::DeleteProtection && status == 404 && message == "Branch not protected");
+        }
+    };
+
+    Plan() = default;
+    Plan(const Server::OwnerName &orgName);
+
+    JSON toJSON() const override;
+    void fromJSON(const JSON &) override;
+
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+
+    void addCollaborator(const Server::RepositoryName &repoName, const Server::UserName &login, const Server::PermissionName &perm);
+    void setProtection(const Server::RepositoryName &repoName, const Server::BranchName &branchName,
+        const UpdateBranchProtection &protection, const std::vector<std::string> &changes);
+    void deleteProtection(const Server::RepositoryName &repoName, const Server::BranchName &branchName);
+
+    /** Run every step through the server's bulk calls, getBulkWorkers() at a time. Results are in step order. */
+    std::vector<Result> apply(Server &server) const;
+
+    const std::string & getOrgName() const { return orgName; }
+    const Step::Vector & getSteps() const { return steps; }
+    size_t requestCount() const { return steps.size(); }
+    size_t count(Action action) const;
+
+    /** How long apply() should take with this many workers. */
+    double estimatedSeconds(int workers) const;
+
+    /** The average time of a request, which estimatedSeconds() is based on. */
+    double getSecondsPerRequest() const { return secondsPerRequest; }
+    Plan & setSecondsPerRequest(double value) { if (value > 0) { secondsPerRequest = value; } return *this; }
+
+    /** The worker count the saved estimate is for. */
+    Plan & setWorkers(int value) { workers = value > 0 ? value : 1; return *this; }
+
+protected:
+    std::string orgName;
+    Step::Vector steps;
+    double secondsPerRequest = 0.5;
+    int workers = 4;
+};
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include <showlib/CommonUsing.h>
+
+#include "RateLimiter.h"
+
+using namespace GitTools;
+
+namespace {
+    /**
+     * Parse a numeric header, returning defaultValue if it's missing.
+     */
+    long headerNumber(const HTTPClient::Response &response, const std::string &name, long defaultValue) {
+        string value = response.header(name);
+        return value.empty() ? defaultValue : std::atol(value.c_str());
+    }
+}
+
+/**
+ * Wait until we may send another request, then count it as in flight. Every call
+ * must be matched by a call to update() or cancel(). Returns true if we had to wait.
+ */
+bool RateLimiter::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool waited = false;
+    Clock::time_point until;
+
+    while (!admit(Clock::now(), until)) {
+        changed.wait_until(lock, until);
+        waited = true;
+    }
+    return waited;
+}
+
+/**
+ * acquire() for callers that can't block, such as the I/O executor. If we may send
+ * now, count the request as in flight and return true. Otherwise return false and
+ * set retryAt to when it's worth asking again; a finishing request may free up
+ * budget before that.
+ */
+bool RateLimiter::tryAcquire(Clock::time_point &retryAt) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return admit(Clock::now(), retryAt);
+}
+
+/**
+ * The decision behind both, with the mutex held.
+ */
+bool RateLimiter::admit(Clock::time_point now, Clock::time_point &until) {
+    time_t nowT = Clock::to_time_t(now);
+
+    if (budget.pausedUntil > nowT) {
+        until = Clock::from_time_t(budget.pausedUntil);
+        return false;
+    }
+
+    if (budget.isKnown() && budget.resetAt > nowT) {
+        int available = budget.remaining - budget.inFlight - reserve;
+
+        // Out of budget until the window resets. We allow a second's slack for clock skew.
+        if (available <= 0) {
+            until = Clock::from_time_t(budget.resetAt + 1);
+            return false;
+        }
+
+        // Running low: spread the rest over the remaining window.
+        if (budget.remaining < paceBelow) {
+            if (now < nextStart) {
+                until = nextStart;
+                return false;
+            }
+            nextStart = now + (Clock::from_time_t(budget.resetAt) - now) / available;
+        }
+    }
+
+    ++budget.inFlight;
+    return true;
+}
+
+/**
+ * A request we acquired for was never sent.
+ */
+void RateLimiter::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget.inFlight = std::max(0, budget.inFlight - 1);
+    changed.notify_all();
+}
+
+/**
+ * A request finished. Take what we can learn from its headers.
+ */
+void RateLimiter::update(const HTTPClient::Response &response) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget.inFlight = std::max(0, budget.inFlight - 1);
+
+    long remaining = headerNumber(response, "x-ratelimit-remaining", -1);
+    if (remaining >= 0) {
+        time_t resetAt = headerNumber(response, "x-ratelimit-reset", 0);
+
+        // With concurrent requests, replies arrive out of order. One from an earlier
+        // window says nothing about this one, and within one window the smallest
+        // remaining count is the most recent.
+        bool stale = budget.isKnown() && resetAt < budget.resetAt;
+        bool newerWindow = !budget.isKnown() || resetAt > budget.resetAt;
+        if (!stale && (newerWindow || remaining < budget.remaining)) {
+            budget.remaining = static_cast<int>(remaining);
+            budget.used = static_cast<int>(headerNumber(response, "x-ratelimit-used", budget.used));
+        }
+        if (!stale) {
+            budget.resetAt = std::max(budget.resetAt, resetAt);
+            budget.limit = static_cast<int>(headerNumber(response, "x-ratelimit-limit", budget.limit));
+        }
+
+        string resource = response.header("x-ratelimit-resource");
+        if (!resource.empty()) {
+            budget.resource = resource;
+        }
+    }
+
+    if (isThrottled(response)) {
+        time_t now = Clock::to_time_t(Clock::now());
+        long retryAfter = headerNumber(response, "retry-after", -1);
+
+        if (retryAfter >= 0) {
+            budget.pausedUntil = std::max(budget.pausedUntil, now + retryAfter);
+        }
+        else if (budget.resetAt > now) {
+            budget.pausedUntil = std::max(budget.pausedUntil, budget.resetAt + 1);
+        }
+        else {
+            // Secondary limits without a Retry-After: GitHub suggests waiting at least a minute.
+            budget.pausedUntil = std::max(budget.pausedUntil, now + 60);
+        }
+    }
+
+    changed.notify_all();
+}
+
+/**
+ * Was this response refused because of a rate limit? A plain 403 (permission denied)
+ * is not.
+ */
+bool RateLimiter::isThrottled(const HTTPClient::Response &response) const {
+    if (response.status == 429) {
+        return true;
+    }
+    if (response.status == 403) {
+        return !response.header("retry-after").empty() || response.header("x-ratelimit-remaining") == "0";
+    }
+    return false;
+}
+
+RateLimiter::Budget RateLimiter::getBudget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+#include "HTTPClient.h"
+
+namespace GitTools {
+    class RateLimiter;
+}
+
+/**
+ * Keeps us inside GitHub's rate limits. Every response carries X-RateLimit-Limit,
+ * -Remaining, -Used and -Reset; throttled responses (403 / 429) may carry Retry-After.
+ * We track the remaining budget, counting requests that are still in flight against
+ * it, and make callers wait in acquire() rather than send a request we know will be
+ * refused.
+ *
+ * While the budget is healthy requests go out as fast as callers make them. Once it
+ * drops below paceBelow we spread what's left evenly over the time to the reset, and
+ * once it reaches the reserve we pause until the reset.
+ */
+class GitTools::RateLimiter
+{
+public:
+    using Clock = std::chrono::system_clock;
+
+    /** What we currently know. The counts are -1 until we've seen a response. */
+    class Budget {
+    public:
+        std::string resource;
+        int limit = -1;
+        int remaining = -1;
+        int used = -1;
+        int inFlight = 0;
+        time_t resetAt = 0;
+        time_t pausedUntil = 0;
+
+        bool isKnown() const { return remaining >= 0; }
+    };
+
+    bool acquire();
+    bool tryAcquire(Clock::time_point &retryAt);
+    void update(const HTTPClient::Response &response);
+    void cancel();
+
+    bool isThrottled(const HTTPClient::Response &response) const;
+
+    Budget getBudget() const;
+
+    RateLimiter & setReserve(int value) { reserve = value; return *this; }
+    RateLimiter & setPaceBelow(int value) { paceBelow = value; return *this; }
+
+protected:
+    bool admit(Clock::time_point now, Clock::time_point &until);
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+
+    Budget budget;
+    Clock::time_point nextStart;
+
+    /** Requests we hold back for other tools sharing the same token. */
+    int reserve = 10;
+
+    /** Below this many remaining, we start pacing. */
+    int paceBelow = 500;
+};
@@ -0,0 +1,177 @@
+#include <sstream>
+#include <stdexcept>
+
+#include <showlib/CommonUsing.h>
+#include <showlib/StringUtils.h>
+
+#include "RecordWriter.h"
+
+using namespace GitTools;
+
+namespace {
+    /** Write to the stream in pieces about this big. */
+    constexpr size_t FlushAt = 64 * 1024;
+}
+
+RecordWriter::RecordWriter(std::ostream &o, Format f, const std::vector<std::string> &names)
+    : out(o), format(f), fields(names)
+{
+    if (fields.empty() && format != Format::NDJSON) {
+        throw std::invalid_argument("CSV and TSV output need a list of fields.");
+    }
+
+    for (const string &field: fields) {
+        std::vector<string> path;
+        std::istringstream keys(field);
+        for (string key; std::getline(keys, key, '.'); ) {
+            path.push_back(key);
+        }
+        paths.push_back(path);
+    }
+    buffer.reserve(FlushAt + 4096);
+}
+
+RecordWriter::~RecordWriter() {
+    flush();
+}
+
+RecordWriter::Format RecordWriter::formatNamed(const std::string &name) {
+    string lower = ShowLib::toLower(ShowLib::trim(name));
+    if (lower == "ndjson" || lower == "jsonl") {
+        return Format::NDJSON;
+    }
+    if (lower == "csv") {
+        return Format::CSV;
+    }
+    if (lower == "tsv") {
+        return Format::TSV;
+    }
+    throw std::invalid_argument("Unknown format: " + name + ". Use ndjson, csv or tsv.");
+}
+
+std::vector<std::string> RecordWriter::fieldsNamed(const std::string &list) {
+    std::vector<string> rv;
+    std::istringstream names(list);
+    for (string name; std::getline(names, name, ','); ) {
+        name = ShowLib::trim(name);
+        if (!name.empty()) {
+            rv.push_back(name);
+        }
+    }
+    return rv;
+}
+
+/**
+ * Follow the path down through nested objects. Returns nullptr if any step is missing.
+ */
+const JSON * RecordWriter::lookup(const JSON &record, const std::vector<std::string> &path) {
+    const JSON *rv = &record;
+    for (const string &key: path) {
+        if (!rv->is_object()) {
+            return nullptr;
+        }
+        auto it = rv->find(key);
+        if (it == rv->end()) {
+            return nullptr;
+        }
+        rv = &*it;
+    }
+    return rv;
+}
+
+void RecordWriter::write(const JSON &record) {
+    if (format == Format::NDJSON) {
+        if (fields.empty()) {
+            buffer += record.dump();
+        }
+        else {
+            JSON selected = JSON::object();
+            for (size_t index = 0; index < fields.size(); ++index) {
+                const JSON *value = lookup(record, paths[index]);
+                selected[fields[index]] = value != nullptr ? *value : JSON();
+            }
+            buffer += selected.dump();
+        }
+    }
+    else {
+        if (!headerWritten) {
+            writeHeader();
+        }
+        for (size_t index = 0; index < paths.size(); ++index) {
+            if (index > 0) {
+                buffer += format == Format::CSV ? ',' : '\t';
+            }
+            writeCell(lookup(record, paths[index]));
+        }
+    }
+    buffer += '\n';
+    ++count;
+
+    if (buffer.size() >= FlushAt) {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+}
+
+/**
+ * A CSV or TSV listing with no records still gets its header.
+ */
+void RecordWriter::flush() {
+    if (!headerWritten && format != Format::NDJSON) {
+        writeHeader();
+    }
+    if (!buffer.empty()) {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+    out.flush();
+}
+
+void RecordWriter::writeHeader() {
+    for (size_t index = 0; index < fields.size(); ++index) {
+        if (index > 0) {
+            buffer += format == Format::CSV ? ',' : '\t';
+        }
+        writeText(fields[index]);
+    }
+    buffer += '\n';
+    headerWritten = true;
+}
+
+/**
+ * Strings as they are, null as nothing, and anything else as its JSON.
+ */
+void RecordWriter::writeCell(const JSON *value) {
+    if (value == nullptr || value->is_null()) {
+        return;
+    }
+    writeText(value->is_string() ? value->get_ref<const string &>() : value->dump());
+}
+
+void RecordWriter::writeText(const std::string &text) {
+    if (format == Format::CSV) {
+        if (text.find_first_of(",\"\r\n") == string::npos) {
+            buffer += text;
+            return;
+        }
+        buffer += '"';
+        for (char c: text) {
+            if (c == '"') {
+                buffer += '"';
+            }
+            buffer += c;
+        }
+        buffer += '"';
+        return;
+    }
+
+    for (char c: text) {
+        switch (c) {
+            case '\t': buffer += "\\t"; break;
+            case '\n': buffer += "\\n"; break;
+            case '\r': buffer += "\\r"; break;
+            case '\\': buffer += "\\\\"; break;
+            default:   buffer += c; break;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <showlib/JSONSerializable.h>
+
+namespace GitTools {
+    class RecordWriter;
+}
+
+/**
+ * Writes listings for other programs to read: one JSON object per line (ndjson),
+ * or comma- or tab-separated rows under a header line. Records are formatted into
+ * our own buffer, which goes to the stream when it fills or on flush(). GitTool
+ * flushes after each page, so the first page is on its way downstream while the
+ * next is still being fetched.
+ *
+ *     RecordWriter writer(cout, RecordWriter::Format::CSV, { "name", "owner.login" });
+ *     server.repositories(orgName).forEachPage([&](const Repository::Vector &page) {
+ *         for (const Repository::Pointer &repo: page) {
+ *             writer.write(repo->toJSON());
+ *         }
+ *         writer.flush();
+ *         return true;
+ *     });
+ *
+ * Fields are keys of the record's JSON, with dots for nested keys such as owner.login.
+ * A missing field is null in ndjson and empty in CSV and TSV. Objects and arrays are
+ * written as JSON. With no fields, ndjson writes the whole record.
+ *
+ * CSV quotes as RFC 4180 does. TSV escapes tab, newline, carriage return and
+ * backslash as \t, \n, \r and \\.
+ */
+class GitTools::RecordWriter
+{
+public:
+    enum class Format { NDJSON, CSV, TSV };
+
+    RecordWriter(std::ostream &out, Format format, const std::vector<std::string> &fields);
+    ~RecordWriter();
+
+    void write(const JSON &record);
+
+    /** Hand what we have to the stream, and flush that too. */
+    void flush();
+
+    const std::vector<std::string> & getFields() const { return fields; }
+    size_t getCount() const { return count; }
+
+    /** "csv" to Format::CSV. Throws std::invalid_argument for a name we don't know. */
+    static Format formatNamed(const std::string &name);
+
+    /** "name, owner.login" to { "name", "owner.login" }. */
+    static std::vector<std::string> fieldsNamed(const std::string &list);
+
+protected:
+    static const JSON * lookup(const JSON &record, const std::vector<std::string> &path);
+
+    void writeHeader();
+    void writeCell(const JSON *value);
+    void writeText(const std::string &text);
+
+    std::ostream & out;
+    Format format;
+    std::vector<std::string> fields;
+    std::vector<std::vector<std::string>> paths;
+
+    std::string buffer;
+    size_t count = 0;
+    bool headerWritten = false;
+};
@@ -1,173 +1,393 @@
+#include <unordered_map>
+
 #include "Repository.h"
 
 using namespace GitTools;
 
+/**
+ * Repository URL templates, in URLTemplate order.
+ */
+const DerivedURLs::Template Repository::urlTemplates[] = {
+    { "archive_url", "/{archive_format}{/ref}" },
+    { "assignees_url", "/assignees{/user}" },
+    { "blobs_url", "/git/blobs{/sha}" },
+    { "branches_url", "/branches{/branch}" },
+    { "collaborators_url", "/collaborators{/collaborator}" },
+    { "comments_url", "/comments{/number}" },
+    { "commits_url", "/commits{/sha}" },
+    { "compare_url", "/compare/{base}...{head}" },
+    { "contents_url", "/contents/{+path}" },
+    { "contributors_url", "/contributors" },
+    { "deployments_url", "/deployments" },
+    { "downloads_url", "/downloads" },
+    { "events_url", "/events" },
+    { "forks_url", "/forks" },
+    { "git_commits_url", "/git/commits{/sha}" },
+    { "git_refs_url", "/git/refs{/sha}" },
+    { "git_tags_url", "/git/tags{/sha}" },
+    { "issue_comment_url", "/issues/comments{/number}" },
+    { "issue_events_url", "/issues/events{/number}" },
+    { "issues_url", "/issues{/number}" },
+    { "keys_url", "/keys{/key_id}" },
+    { "labels_url", "/labels{/name}" },
+    { "languages_url", "/languages" },
+    { "merges_url", "/merges" },
+    { "milestones_url", "/milestones{/number}" },
+    { "notifications_url", "/notifications{?since,all,participating}" },
+    { "pulls_url", "/pulls{/number}" },
+    { "releases_url", "/releases{/id}" },
+    { "stargazers_url", "/stargazers" },
+    { "statuses_url", "/statuses/{sha}" },
+    { "subscribers_url", "/subscribers" },
+    { "subscription_url", "/subscription" },
+    { "tags_url", "/tags" },
+    { "teams_url", "/teams" },
+    { "trees_url", "/git/trees{/sha}" },
+    { "hooks_url", "/hooks" },
+};
+
+/**
+ * Owner URL templates, in URLTemplate order.
+ */
+const DerivedURLs::Template Repository::Owner::urlTemplates[] = {
+    { "followers_url", "/followers" },
+    { "following_url", "/following{/other_user}" },
+    { "gists_url", "/gists{/gist_id}" },
+    { "starred_url", "/starred{/owner}{/repo}" },
+    { "subscriptions_url", "/subscriptions" },
+    { "organizations_url", "/orgs" },
+    { "repos_url", "/repos" },
+    { "events_url", "/events{/privacy}" },
+    { "received_events_url", "/received_events" },
+};
+
+namespace {
+    /** How the stream decoder sets one top-level field. */
+    class FieldSetter {
+    public:
+        Repository::Fields group;
+        void (*set)(Repository &, FieldValue &);
+    };
+
+    const std::unordered_map<std::string, FieldSetter> & fieldSetters() {
+        static const std::unordered_map<std::string, FieldSetter> setters {
+            { "id", { Repository::IdentityFields, [](Repository &r, FieldValue &v) { r.id = v.asInt(); } } },
+            { "node_id", { Repository::IdentityFields, [](Repository &r, FieldValue &v) { r.nodeId = v.takeString(); } } },
+            { "name", { Repository::IdentityFields, [](Repository &r, FieldValue &v) { r.name = v.takeString(); } } },
+            { "full_name", { Repository::IdentityFields, [](Repository &r, FieldValue &v) { r.fullName = v.takeString(); } } },
+            { "url", { Repository::IdentityFields, [](Repository &r, FieldValue &v) { r.url = v.takeString(); } } },
+            { "html_url", { Repository::IdentityFields, [](Repository &r, FieldValue &v) { r.html_url = v.takeString(); } } },
+            { "description", { Repository::DescriptionFields, [](Repository &r, FieldValue &v) { r.description = v.takeString(); } } },
+            { "homepage", { Repository::DescriptionFields, [](Repository &r, FieldValue &v) { r.homepage = v.takeString(); } } },
+            { "git_url", { Repository::URLFields, [](Repository &r, FieldValue &v) { r.git_url = v.takeString(); } } },
+            { "ssh_url", { Repository::URLFields, [](Repository &r, FieldValue &v) { r.ssh_url = v.takeString(); } } },
+            { "clone_url", { Repository::URLFields, [](Repository &r, FieldValue &v) { r.clone_url = v.takeString(); } } },
+            { "mirror_url", { Repository::URLFields, [](Repository &r, FieldValue &v) { r.mirror_url = v.takeString(); } } },
+            { "svn_url", { Repository::URLFields, [](Repository &r, FieldValue &v) { r.svn_url = v.takeString(); } } },
+            { "language", { Repository::LanguageFields, [](Repository &r, FieldValue &v) { r.language = v.takeString(); } } },
+            { "default_branch", { Repository::BranchFields, [](Repository &r, FieldValue &v) { r.default_branch = v.takeString(); } } },
+            { "visibility", { Repository::VisibilityFields, [](Repository &r, FieldValue &v) { r.visibility = v.takeString(); } } },
+            { "private", { Repository::VisibilityFields, [](Repository &r, FieldValue &v) { r.isPrivate = v.asBool(); } } },
+            { "pushed_at", { Repository::DateFields, [](Repository &r, FieldValue &v) { r.pushed_at = v.takeString(); } } },
+            { "created_at", { Repository::DateFields, [](Repository &r, FieldValue &v) { r.created_at = v.takeString(); } } },
+            { "updated_at", { Repository::DateFields, [](Repository &r, FieldValue &v) { r.updated_at = v.takeString(); } } },
+            { "forks_count", { Repository::CountFields, [](Repository &r, FieldValue &v) { r.forks_count = v.asInt(); } } },
+            { "stargazers_count", { Repository::CountFields, [](Repository &r, FieldValue &v) { r.stargazers_count = v.asInt(); } } },
+            { "watchers_count", { Repository::CountFields, [](Repository &r, FieldValue &v) { r.watchers_count = v.asInt(); } } },
+            { "size", { Repository::CountFields, [](Repository &r, FieldValue &v) { r.size = v.asInt(); } } },
+            { "open_issues_count", { Repository::CountFields, [](Repository &r, FieldValue &v) { r.open_issues_count = v.asInt(); } } },
+            { "template_repository", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.template_repository = v.takeString(); } } },
+            { "is_template", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.is_template = v.asInt(); } } },
+            { "fork", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.fork = v.asBool(); } } },
+            { "has_issues", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.has_issues = v.asBool(); } } },
+            { "has_projects", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.has_projects = v.asBool(); } } },
+            { "has_wiki", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.has_wiki = v.asBool(); } } },
+            { "has_pages", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.has_pages = v.asBool(); } } },
+            { "has_downloads", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.has_downloads = v.asBool(); } } },
+            { "archived", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.archived = v.asBool(); } } },
+            { "disabled", { Repository::FlagFields, [](Repository &r, FieldValue &v) { r.disabled = v.asBool(); } } },
+        };
+        return setters;
+    }
+
+    /** How the stream decoder sets one of the owner's fields. */
+    typedef void (*OwnerSetter)(Repository::Owner &, FieldValue &);
+
+    const std::unordered_map<std::string, OwnerSetter> & ownerSetters() {
+        static const std::unordered_map<std::string, OwnerSetter> setters {
+            { "login", [](Repository::Owner &o, FieldValue &v) { o.login = v.takeString(); } },
+            { "node_id", [](Repository::Owner &o, FieldValue &v) { o.nodeId = v.takeString(); } },
+            { "avatar_url", [](Repository::Owner &o, FieldValue &v) { o.avatarURL = v.takeString(); } },
+            { "gravatar_id", [](Repository::Owner &o, FieldValue &v) { o.gravatarID = v.takeString(); } },
+            { "url", [](Repository::Owner &o, FieldValue &v) { o.setURL(v.takeString()); } },
+            { "html_url", [](Repository::Owner &o, FieldValue &v) { o.htmlURL = v.takeString(); } },
+            { "type", [](Repository::Owner &o, FieldValue &v) { o.type = v.takeString(); } },
+            { "id", [](Repository::Owner &o, FieldValue &v) { o.id = v.asInt(); } },
+            { "site_admin", [](Repository::Owner &o, FieldValue &v) { o.siteAdmin = v.asBool(); } },
+        };
+        return setters;
+    }
+
+    /** And of its permissions. */
+    typedef void (*PermissionsSetter)(Repository::Permissions &, FieldValue &);
+
+    const std::unordered_map<std::string, PermissionsSetter> & permissionsSetters() {
+        static const std::unordered_map<std::string, PermissionsSetter> setters {
+            { "admin", [](Repository::Permissions &p, FieldValue &v) { p.admin = v.asBool(); } },
+            { "push", [](Repository::Permissions &p, FieldValue &v) { p.push = v.asBool(); } },
+            { "pull", [](Repository::Permissions &p, FieldValue &v) { p.pull = v.asBool(); } },
+        };
+        return setters;
+    }
+
+    /**
+     * Map each key in a URL template table to its index.
+     */
+    std::unordered_map<std::string, size_t> indexTemplates(const DerivedURLs::Template *table, size_t count) {
+        std::unordered_map<std::string, size_t> indexes;
+        for (size_t index = 0; index < count; ++index) {
+            indexes[table[index].key] = index;
+        }
+        return indexes;
+    }
+}
+
 Repository::Repository()
 {
 }
 
 void Repository::fromJSON(const JSON &json) {
-    JSON ownerJSON = jsonValue(json, "owner");
-    JSON permJSON = jsonValue(json, "permissions");
-    JSON topicsArray = jsonArray(json, "topics");
+    fromJSON(json, AllFields);
+}
+
+Repository::Fields Repository::fieldsFor(const std::string &key) {
+    auto it = fieldSetters().find(key);
+    if (it != fieldSetters().end()) {
+        return it->second.group;
+    }
+    if (key == "owner") {
+        return OwnerFields;
+    }
+    if (key == "permissions") {
+        return PermissionFields;
+    }
+    if (key == "topics") {
+        return TopicFields;
+    }
+    for (size_t index = 0; index < static_cast<size_t>(URLTemplate::Count); ++index) {
+        if (key == urlTemplates[index].key) {
+            return URLFields;
+        }
+    }
+    return AllFields;
+}
 
-    owner.fromJSON(ownerJSON);
-    permissions.fromJSON(permJSON);
-    topics.fromJSON(topicsArray);
+/**
+ * Read only the requested groups of fields. Everything else keeps its default value.
+ */
+void Repository::fromJSON(const JSON &json, Fields wanted) {
+    fields = wanted;
 
-    nodeId = stringValue(json, "node_id");
-    name = stringValue(json, "name");
-    fullName = stringValue(json, "full_name");
-    html_url = stringValue(json, "html_url");
-    description = stringValue(json, "description");
-    url = stringValue(json, "url");
-    archive_url = stringValue(json, "archive_url");
-    assignees_url = stringValue(json, "assignees_url");
-    blobs_url = stringValue(json, "blobs_url");
-    branches_url = stringValue(json, "branches_url");
-    collaborators_url = stringValue(json, "collaborators_url");
-    comments_url = stringValue(json, "comments_url");
-    commits_url = stringValue(json, "commits_url");
-    compare_url = stringValue(json, "compare_url");
-    contents_url = stringValue(json, "contents_url");
-    contributors_url = stringValue(json, "contributors_url");
-    deployments_url = stringValue(json, "deployments_url");
-    downloads_url = stringValue(json, "downloads_url");
-    events_url = stringValue(json, "events_url");
-    forks_url = stringValue(json, "forks_ur");
-    git_commits_url = stringValue(json, "git_commits_url");
-    git_refs_url = stringValue(json, "git_refs_url");
-    git_tags_url = stringValue(json, "git_tags_url");
-    git_url = stringValue(json, "git_url");
-    issue_comment_url = stringValue(json, "issue_comment_url");
-    issue_events_url = stringValue(json, "issue_events_url");
-    issues_url = stringValue(json, "issues_url");
-    keys_url = stringValue(json, "keys_url");
-    labels_url = stringValue(json, "labels_url");
-    languages_url = stringValue(json, "languages_url");
-    merges_url = stringValue(json, "merges_url");
-    milestones_url = stringValue(json, "milestones_url");
-    notifications_url = stringValue(json, "notifications_url");
-    pulls_url = stringValue(json, "pulls_url");
-    releases_url = stringValue(json, "releases_url");
-    ssh_url = stringValue(json, "ssh_url");
-    stargazers_url = stringValue(json, "stargazers_url");
-    statuses_url = stringValue(json, "statuses_url");
-    subscribers_url = stringValue(json, "subscribers_url");
-    subscription_url = stringValue(json, "subscription_url");
-    tags_url = stringValue(json, "tags_url");
-    teams_url = stringValue(json, "teams_url");
-    trees_url = stringValue(json, "trees_url");
-    clone_url = stringValue(json, "clone_url");
-    mirror_url = stringValue(json, "mirror_url");
-    hooks_url = stringValue(json, "hooks_url");
-    svn_url = stringValue(json, "svn_url");
-    homepage = stringValue(json, "homepage");
-    language = stringValue(json, "language");
-    default_branch = stringValue(json, "default_branch");
-    visibility = stringValue(json, "visibility");
-    pushed_at = stringValue(json, "pushed_at");
-    created_at = stringValue(json, "updated_at");
-    template_repository = stringValue(json, "template_repository");
-
-    forks_count = intValue(json, "forks_count");
-    stargazers_count = intValue(json, "stargazers_count");
-    watchers_count = intValue(json, "watchers_count");
-    size = intValue(json, "size");
-    id = intValue(json, "id");
-    open_issues_count = intValue(json, "open_issues_count");
-    is_template = intValue(json, "is_template");
-
-    isPrivate = boolValue(json, "private");
-    fork = boolValue(json, "fork");
-    has_issues = boolValue(json, "has_issues");
-    has_projects = boolValue(json, "has_projects");
-    has_wiki = boolValue(json, "has_wiki");
-    has_pages = boolValue(json, "has_pages");
-    has_downloads = boolValue(json, "has_downloads");
-    archived = boolValue(json, "archived");
-    disabled = boolValue(json, "disabled");
+    if (fields & OwnerFields) {
+        owner.fromJSON(jsonValue(json, "owner"));
+    }
+    if (fields & PermissionFields) {
+        permissions.fromJSON(jsonValue(json, "permissions"));
+    }
+    if (fields & TopicFields) {
+        topics.fromJSON(jsonArray(json, "topics"));
+    }
+
+    if (fields & IdentityFields) {
+        id = intValue(json, "id");
+        nodeId = stringValue(json, "node_id");
+        name = stringValue(json, "name");
+        fullName = stringValue(json, "full_name");
+        url = stringValue(json, "url");
+        html_url = stringValue(json, "html_url");
+    }
+
+    if (fields & DescriptionFields) {
+        description = stringValue(json, "description");
+        homepage = stringValue(json, "homepage");
+    }
+
+    if (fields & URLFields) {
+        for (size_t index = 0; index < static_cast<size_t>(URLTemplate::Count); ++index) {
+            urls.set(url, urlTemplates, index, stringValue(json, urlTemplates[index].key));
+        }
+
+        git_url = stringValue(json, "git_url");
+        ssh_url = stringValue(json, "ssh_url");
+        clone_url = stringValue(json, "clone_url");
+        mirror_url = stringValue(json, "mirror_url");
+        svn_url = stringValue(json, "svn_url");
+    }
+
+    if (fields & LanguageFields) {
+        language = stringValue(json, "language");
+    }
+
+    if (fields & BranchFields) {
+        default_branch = stringValue(json, "default_branch");
+    }
+
+    if (fields & VisibilityFields) {
+        visibility = stringValue(json, "visibility");
+        isPrivate = boolValue(json, "private");
+    }
+
+    if (fields & DateFields) {
+        pushed_at = stringValue(json, "pushed_at");
+        created_at = stringValue(json, "created_at");
+        updated_at = stringValue(json, "updated_at");
+    }
+
+    if (fields & CountFields) {
+        forks_count = intValue(json, "forks_count");
+        stargazers_count = intValue(json, "stargazers_count");
+        watchers_count = intValue(json, "watchers_count");
+        size = intValue(json, "size");
+        open_issues_count = intValue(json, "open_issues_count");
+    }
+
+    if (fields & FlagFields) {
+        template_repository = stringValue(json, "template_repository");
+        is_template = intValue(json, "is_template");
+        fork = boolValue(json, "fork");
+        has_issues = boolValue(json, "has_issues");
+        has_projects = boolValue(json, "has_projects");
+        has_wiki = boolValue(json, "has_wiki");
+        has_pages = boolValue(json, "has_pages");
+        has_downloads = boolValue(json, "has_downloads");
+        archived = boolValue(json, "archived");
+        disabled = boolValue(json, "disabled");
+    }
 }
 
+/**
+ * Take one field from the stream decoder. See PageParser for what section means.
+ */
+void Repository::decodeField(const std::string &section, const std::string &key, FieldValue &value) {
+    if (!section.empty()) {
+        if (section == "owner" && (fields & OwnerFields)) {
+            owner.decodeField(key, value);
+        }
+        else if (section == "permissions" && (fields & PermissionFields)) {
+            permissions.decodeField(key, value);
+        }
+        return;
+    }
+
+    if (key == "topics") {
+        if ((fields & TopicFields) && !value.isNull()) {
+            topics.add(value.takeString());
+        }
+        return;
+    }
+
+    const auto &setters = fieldSetters();
+    auto it = setters.find(key);
+    if (it != setters.end()) {
+        if (fields & it->second.group) {
+            it->second.set(*this, value);
+            if (key == "url" && (fields & URLFields)) {
+                urls.rebase(url, urlTemplates);
+            }
+        }
+        return;
+    }
+
+    if (fields & URLFields) {
+        static const auto indexes = indexTemplates(urlTemplates, static_cast<size_t>(URLTemplate::Count));
+        auto found = indexes.find(key);
+        if (found != indexes.end()) {
+            urls.set(url, urlTemplates, found->second, value.takeString());
+        }
+    }
+}
+
+/**
+ * Output to JSON. We only write the groups of fields we read.
+ */
 JSON Repository::toJSON() const {
     JSON json = JSON::object();
 
-    json["owner"] =  owner.toJSON();
-    json["permissions"] =  permissions.toJSON();
-    json["topics"] =  topics.toJSON();
+    if (fields & OwnerFields) {
+        json["owner"] =  owner.toJSON();
+    }
+    if (fields & PermissionFields) {
+        json["permissions"] =  permissions.toJSON();
+    }
+    if (fields & TopicFields) {
+        json["topics"] =  topics.toJSON();
+    }
 
-    json[ "node_id" ] = nodeId;
-    json[ "name" ] = name;
-    json[ "full_name" ] = fullName;
-    json[ "html_url" ] = html_url;
-    json[ "description" ] = description;
-    json[ "url" ] = url;
-    json[ "archive_url" ] = archive_url;
-    json[ "assignees_url" ] = assignees_url;
-    json[ "blobs_url" ] = blobs_url;
-    json[ "branches_url" ] = branches_url;
-    json[ "collaborators_url" ] = collaborators_url;
-    json[ "comments_url" ] = comments_url;
-    json[ "commits_url" ] = commits_url;
-    json[ "compare_url" ] = compare_url;
-    json[ "contents_url" ] = contents_url;
-    json[ "contributors_url" ] = contributors_url;
-    json[ "deployments_url" ] = deployments_url;
-    json[ "downloads_url" ] = downloads_url;
-    json[ "events_url" ] = events_url;
-    json[ "forks_url" ] = forks_url;
-    json[ "git_commits_url" ] = git_commits_url;
-    json[ "git_refs_url" ] = git_refs_url;
-    json[ "git_tags_url" ] = git_tags_url;
-    json[ "git_url" ] = git_url;
-    json[ "issue_comment_url" ] = issue_comment_url;
-    json[ "issue_events_url" ] = issue_events_url;
-    json[ "issues_url" ] = issues_url;
-    json[ "keys_url" ] = keys_url;
-    json[ "labels_url" ] = labels_url;
-    json[ "languages_url" ] = languages_url;
-    json[ "merges_url" ] = merges_url;
-    json[ "milestones_url" ] = milestones_url;
-    json[ "notifications_url" ] = notifications_url;
-    json[ "pulls_url" ] = pulls_url;
-    json[ "releases_url" ] = releases_url;
-    json[ "ssh_url" ] = ssh_url;
-    json[ "stargazers_url" ] = stargazers_url;
-    json[ "statuses_url" ] = statuses_url;
-    json[ "subscribers_url" ] = subscribers_url;
-    json[ "subscription_url" ] = subscription_url;
-    json[ "tags_url" ] = tags_url;
-    json[ "teams_url" ] = teams_url;
-    json[ "trees_url" ] = trees_url;
-    json[ "clone_url" ] = clone_url;
-    json[ "mirror_url" ] = mirror_url;
-    json[ "hooks_url" ] = hooks_url;
-    json[ "svn_url" ] = svn_url;
-    json[ "homepage" ] = homepage;
-    json[ "language" ] = language;
-    json[ "default_branch" ] = default_branch;
-    json[ "visibility" ] = visibility;
-    json[ "pushed_at" ] = pushed_at;
-    json[ "updated_at" ] = updated_at;
-    json[ "template_repository" ] = template_repository;
-
-    json[ "forks_count" ] = forks_count;
-    json[ "stargazers_count" ] = stargazers_count;
-    json[ "watchers_count" ] = watchers_count;
-    json[ "size" ] = size;
-    json[ "id" ] = id;
-    json[ "open_issues_count" ] = open_issues_count;
-    json[ "is_template" ] = is_template;
-
-    json[ "private" ] = isPrivate;
-    json[ "fork" ] = fork;
-    json[ "has_issues" ] = has_issues;
-    json[ "has_projects" ] = has_projects;
-    json[ "has_wiki" ] = has_wiki;
-    json[ "has_pages" ] = has_pages;
-    json[ "has_downloads" ] = has_pages;
-    json[ "archived" ] = archived;
-    json[ "disabled" ] = disabled;
+    if (fields & IdentityFields) {
+        json[ "id" ] = id;
+        json[ "node_id" ] = nodeId;
+        json[ "name" ] = name;
+        json[ "full_name" ] = fullName;
+        json[ "url" ] = url;
+        json[ "html_url" ] = html_url;
+    }
+
+    if (fields & DescriptionFields) {
+        json[ "description" ] = description;
+        json[ "homepage" ] = homepage;
+    }
+
+    if (fields & URLFields) {
+        for (size_t index = 0; index < static_cast<size_t>(URLTemplate::Count); ++index) {
+            json[ urlTemplates[index].key ] = urls.get(url, urlTemplates, index);
+        }
+
+        json[ "git_url" ] = git_url;
+        json[ "ssh_url" ] = ssh_url;
+        json[ "clone_url" ] = clone_url;
+        json[ "mirror_url" ] = mirror_url;
+        json[ "svn_url" ] = svn_url;
+    }
+
+    if (fields & LanguageFields) {
+        json[ "language" ] = language;
+    }
+
+    if (fields & BranchFields) {
+        json[ "default_branch" ] = default_branch;
+    }
+
+    if (fields & VisibilityFields) {
+        json[ "visibility" ] = visibility;
+        json[ "private" ] = isPrivate;
+    }
+
+    if (fields & DateFields) {
+        json[ "pushed_at" ] = pushed_at;
+        json[ "created_at" ] = created_at;
+        json[ "updated_at" ] = updated_at;
+    }
+
+    if (fields & CountFields) {
+        json[ "forks_count" ] = forks_count;
+        json[ "stargazers_count" ] = stargazers_count;
+        json[ "watchers_count" ] = watchers_count;
+        json[ "size" ] = size;
+        json[ "open_issues_count" ] = open_issues_count;
+    }
+
+    if (fields & FlagFields) {
+        json[ "template_repository" ] = template_repository;
+        json[ "is_template" ] = is_template;
+        json[ "fork" ] = fork;
+        json[ "has_issues" ] = has_issues;
+        json[ "has_projects" ] = has_projects;
+        json[ "has_wiki" ] = has_wiki;
+        json[ "has_pages" ] = has_pages;
+        json[ "has_downloads" ] = has_downloads;
+        json[ "archived" ] = archived;
+        json[ "disabled" ] = disabled;
+    }
 
     return json;
 }
@@ -179,20 +399,39 @@ void Repository::Owner::fromJSON(const JSON &json) {
     gravatarID = stringValue(json, "gravatar_id");
     url = stringValue(json, "url");
     htmlURL = stringValue(json, "html_url");
-    followersURL = stringValue(json, "followers_url");
-    followingURL = stringValue(json, "following_url");
-    gistsURL = stringValue(json, "gists_url");
-    starredURL = stringValue(json, "started_url");
-    subscriptionsURL = stringValue(json, "subscriptions_url");
-    organizationsURL = stringValue(json, "organizations_url");
-    reposURL = stringValue(json, "repos_url");
-    eventsURL = stringValue(json, "events_url");
-    receivedEventsURL = stringValue(json, "received_events_url");
+    for (size_t index = 0; index < static_cast<size_t>(URLTemplate::Count); ++index) {
+        urls.set(url, urlTemplates, index, stringValue(json, urlTemplates[index].key));
+    }
     type = stringValue(json, "type");
     id = intValue(json, "id");
     siteAdmin = boolValue(json, "site_admin");
 }
 
+/**
+ * Take one field from the stream decoder.
+ */
+void Repository::Owner::decodeField(const std::string &key, FieldValue &value) {
+    auto setter = ownerSetters().find(key);
+    if (setter != ownerSetters().end()) {
+        setter->second(*this, value);
+        return;
+    }
+
+    static const auto indexes = indexTemplates(urlTemplates, static_cast<size_t>(URLTemplate::Count));
+    auto it = indexes.find(key);
+    if (it != indexes.end()) {
+        urls.set(url, urlTemplates, it->second, value.takeString());
+    }
+}
+
+/**
+ * Set url, and derive any templates that arrived before it.
+ */
+void Repository::Owner::setURL(std::string &&value) {
+    url = std::move(value);
+    urls.rebase(url, urlTemplates);
+}
+
 JSON Repository::Owner::toJSON() const {
     JSON json = JSON::object();
 
@@ -202,15 +441,9 @@ JSON Repository::Owner::toJSON() const {
     json[ "gravatar_id" ] = gravatarID;
     json[ "url" ] = url;
     json[ "html_url" ] = htmlURL;
-    json[ "followers_url" ] = followersURL;
-    json[ "following_url" ] = followingURL;
-    json[ "gists_url" ] = gistsURL;
-    json[ "started_url" ] = starredURL;
-    json[ "subscriptions_url" ] = subscriptionsURL;
-    json[ "organizations_url" ] = organizationsURL;
-    json[ "repos_url" ] = reposURL;
-    json[ "events_url" ] = eventsURL;
-    json[ "received_events_url" ] = receivedEventsURL;
+    for (size_t index = 0; index < static_cast<size_t>(URLTemplate::Count); ++index) {
+        json[ urlTemplates[index].key ] = urls.get(url, urlTemplates, index);
+    }
     json[ "type" ] = type;
     json[ "id" ] = id;
     json[ "site_admin" ] = siteAdmin;
@@ -224,6 +457,16 @@ void Repository::Permissions::fromJSON(const JSON &json) {
     pull = boolValue(json, "pull");
 }
 
+/**
+ * Take one field from the stream decoder.
+ */
+void Repository::Permissions::decodeField(const std::string &key, FieldValue &value) {
+    auto it = permissionsSetters().find(key);
+    if (it != permissionsSetters().end()) {
+        it->second(*this, value);
+    }
+}
+
 JSON Repository::Permissions::toJSON() const {
     JSON json = JSON::object();
 
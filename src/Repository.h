@@ -1,9 +1,14 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <showlib/JSONSerializable.h>
 #include <showlib/StringVector.h>
 
+#include "DerivedURLs.h"
+#include "NameIndex.h"
+#include "StreamDecoder.h"
+
 namespace GitTools {
     class Repository;
 }
@@ -13,6 +18,28 @@ class GitTools::Repository: public ShowLib::JSONSerializable
 public:
     typedef std::shared_ptr<Repository> Pointer;
     typedef ShowLib::JSONSerializableVector<Repository> Vector;
+    typedef PackedVector<Repository> Packed;
+    typedef NameIndex<Repository> Index;
+
+    /**
+     * Groups of fields, for reading only what you need. Most of a repo is URL templates
+     * that few tools use, so a listing that only wants names can skip them.
+     */
+    typedef uint32_t Fields;
+
+    static constexpr Fields IdentityFields    = 0x0001;  // id, node_id, name, full_name, url, html_url
+    static constexpr Fields DescriptionFields = 0x0002;  // description, homepage
+    static constexpr Fields VisibilityFields  = 0x0004;  // visibility, private
+    static constexpr Fields BranchFields      = 0x0008;  // default_branch
+    static constexpr Fields FlagFields        = 0x0010;  // fork, archived, disabled, has_*, templates
+    static constexpr Fields CountFields       = 0x0020;  // forks, stargazers, watchers, size, open issues
+    static constexpr Fields DateFields        = 0x0040;  // pushed_at, created_at, updated_at
+    static constexpr Fields LanguageFields    = 0x0080;  // language
+    static constexpr Fields URLFields         = 0x0100;  // the *_url templates plus git/ssh/clone/svn/mirror
+    static constexpr Fields OwnerFields       = 0x0200;  // owner
+    static constexpr Fields PermissionFields  = 0x0400;  // permissions
+    static constexpr Fields TopicFields       = 0x0800;  // topics
+    static constexpr Fields AllFields         = 0xFFFFFFFF;
 
     class Owner: public ShowLib::JSONSerializable
     {
@@ -23,32 +50,57 @@ public:
         std::string gravatarID;
         std::string url;
         std::string htmlURL;
-        std::string followersURL;
-        std::string followingURL;
-        std::string gistsURL;
-        std::string starredURL;
-        std::string subscriptionsURL;
-        std::string organizationsURL;
-        std::string reposURL;
-        std::string eventsURL;
-        std::string receivedEventsURL;
         std::string type;
-        int id;
-        bool siteAdmin;
+        int id = 0;
+        bool siteAdmin = false;
+
+        /** The URL templates we derive from url. */
+        enum class URLTemplate {
+            Followers,
+            Following,
+            Gists,
+            Starred,
+            Subscriptions,
+            Organizations,
+            Repos,
+            Events,
+            ReceivedEvents,
+            Count
+        };
+        static const DerivedURLs::Template urlTemplates[];
+
+        std::string urlTemplate(URLTemplate which) const { return urls.get(url, urlTemplates, static_cast<size_t>(which)); }
+        void setURLTemplate(URLTemplate which, const std::string &value) { urls.set(url, urlTemplates, static_cast<size_t>(which), value); }
+
+        std::string followersURL() const { return urlTemplate(URLTemplate::Followers); }
+        std::string followingURL() const { return urlTemplate(URLTemplate::Following); }
+        std::string gistsURL() const { return urlTemplate(URLTemplate::Gists); }
+        std::string starredURL() const { return urlTemplate(URLTemplate::Starred); }
+        std::string subscriptionsURL() const { return urlTemplate(URLTemplate::Subscriptions); }
+        std::string organizationsURL() const { return urlTemplate(URLTemplate::Organizations); }
+        std::string reposURL() const { return urlTemplate(URLTemplate::Repos); }
+        std::string eventsURL() const { return urlTemplate(URLTemplate::Events); }
+        std::string receivedEventsURL() const { return urlTemplate(URLTemplate::ReceivedEvents); }
 
         void fromJSON(const JSON &) override;
         JSON toJSON() const override;
+        void decodeField(const std::string &key, FieldValue &value);
+        void setURL(std::string &&value);
+
+    protected:
+        DerivedURLs urls;
     };
 
     class Permissions: public ShowLib::JSONSerializable
     {
     public:
-        bool admin;
-        bool push;
-        bool pull;
+        bool admin = false;
+        bool push = false;
+        bool pull = false;
 
         void fromJSON(const JSON &) override;
         JSON toJSON() const override;
+        void decodeField(const std::string &key, FieldValue &value);
     };
 
     //======================================================================
@@ -57,11 +109,109 @@ public:
     Repository();
 
     void fromJSON(const JSON &) override;
+    void fromJSON(const JSON &, Fields);
     JSON toJSON() const override;
 
+    /** Used by StreamDecoder. Honors fields, so set that first. */
+    void decodeField(const std::string &section, const std::string &key, FieldValue &value);
+
+    /**
+     * The URL templates we derive from url, such as
+     * https://api.github.com/repos/octocat/Hello-World/branches{/branch}
+     */
+    enum class URLTemplate {
+        Archive,
+        Assignees,
+        Blobs,
+        Branches,
+        Collaborators,
+        Comments,
+        Commits,
+        Compare,
+        Contents,
+        Contributors,
+        Deployments,
+        Downloads,
+        Events,
+        Forks,
+        GitCommits,
+        GitRefs,
+        GitTags,
+        IssueComment,
+        IssueEvents,
+        Issues,
+        Keys,
+        Labels,
+        Languages,
+        Merges,
+        Milestones,
+        Notifications,
+        Pulls,
+        Releases,
+        Stargazers,
+        Statuses,
+        Subscribers,
+        Subscription,
+        Tags,
+        Teams,
+        Trees,
+        Hooks,
+        Count
+    };
+    static const DerivedURLs::Template urlTemplates[];
+
+    std::string urlTemplate(URLTemplate which) const { return urls.get(url, urlTemplates, static_cast<size_t>(which)); }
+    void setURLTemplate(URLTemplate which, const std::string &value) { urls.set(url, urlTemplates, static_cast<size_t>(which), value); }
+
+    std::string archive_url() const { return urlTemplate(URLTemplate::Archive); }
+    std::string assignees_url() const { return urlTemplate(URLTemplate::Assignees); }
+    std::string blobs_url() const { return urlTemplate(URLTemplate::Blobs); }
+    std::string branches_url() const { return urlTemplate(URLTemplate::Branches); }
+    std::string collaborators_url() const { return urlTemplate(URLTemplate::Collaborators); }
+    std::string comments_url() const { return urlTemplate(URLTemplate::Comments); }
+    std::string commits_url() const { return urlTemplate(URLTemplate::Commits); }
+    std::string compare_url() const { return urlTemplate(URLTemplate::Compare); }
+    std::string contents_url() const { return urlTemplate(URLTemplate::Contents); }
+    std::string contributors_url() const { return urlTemplate(URLTemplate::Contributors); }
+    std::string deployments_url() const { return urlTemplate(URLTemplate::Deployments); }
+    std::string downloads_url() const { return urlTemplate(URLTemplate::Downloads); }
+    std::string events_url() const { return urlTemplate(URLTemplate::Events); }
+    std::string forks_url() const { return urlTemplate(URLTemplate::Forks); }
+    std::string git_commits_url() const { return urlTemplate(URLTemplate::GitCommits); }
+    std::string git_refs_url() const { return urlTemplate(URLTemplate::GitRefs); }
+    std::string git_tags_url() const { return urlTemplate(URLTemplate::GitTags); }
+    std::string issue_comment_url() const { return urlTemplate(URLTemplate::IssueComment); }
+    std::string issue_events_url() const { return urlTemplate(URLTemplate::IssueEvents); }
+    std::string issues_url() const { return urlTemplate(URLTemplate::Issues); }
+    std::string keys_url() const { return urlTemplate(URLTemplate::Keys); }
+    std::string labels_url() const { return urlTemplate(URLTemplate::Labels); }
+    std::string languages_url() const { return urlTemplate(URLTemplate::Languages); }
+    std::string merges_url() const { return urlTemplate(URLTemplate::Merges); }
+    std::string milestones_url() const { return urlTemplate(URLTemplate::Milestones); }
+    std::string notifications_url() const { return urlTemplate(URLTemplate::Notifications); }
+    std::string pulls_url() const { return urlTemplate(URLTemplate::Pulls); }
+    std::string releases_url() const { return urlTemplate(URLTemplate::Releases); }
+    std::string stargazers_url() const { return urlTemplate(URLTemplate::Stargazers); }
+    std::string statuses_url() const { return urlTemplate(URLTemplate::Statuses); }
+    std::string subscribers_url() const { return urlTemplate(URLTemplate::Subscribers); }
+    std::string subscription_url() const { return urlTemplate(URLTemplate::Subscription); }
+    std::string tags_url() const { return urlTemplate(URLTemplate::Tags); }
+    std::string teams_url() const { return urlTemplate(URLTemplate::Teams); }
+    std::string trees_url() const { return urlTemplate(URLTemplate::Trees); }
+    std::string hooks_url() const { return urlTemplate(URLTemplate::Hooks); }
+
+    /** Key function for Index. */
+    static const std::string & indexByName(const Repository &repo) { return repo.name; }
+
+    /** The group holding this top-level key, or AllFields if we don't know it. */
+    static Fields fieldsFor(const std::string &key);
+
     //======================================================================
     // Fields.
     //======================================================================
+    /** Which groups of fields were read. */
+    Fields fields = AllFields;
+
     Owner owner;
     Permissions permissions;
     ShowLib::StringVector topics;
@@ -72,46 +222,10 @@ public:
     std::string html_url; // https://github.com/octocat/Hello-World
     std::string description;
     std::string url; // https://api.github.com/repos/octocat/Hello-World
-    std::string archive_url; // https://api.github.com/repos/octocat/Hello-World/{archive_format}{/ref}
-    std::string assignees_url; // https://api.github.com/repos/octocat/Hello-World/assignees{/user}
-    std::string blobs_url; // https://api.github.com/repos/octocat/Hello-World/git/blobs{/sha}
-    std::string branches_url; // https://api.github.com/repos/octocat/Hello-World/branches{/branch}
-    std::string collaborators_url; // https://api.github.com/repos/octocat/Hello-World/collaborators{/collaborator}
-    std::string comments_url; // https://api.github.com/repos/octocat/Hello-World/comments{/number}
-    std::string commits_url; // https://api.github.com/repos/octocat/Hello-World/commits{/sha}
-    std::string compare_url; // https://api.github.com/repos/octocat/Hello-World/compare/{base}...{head}
-    std::string contents_url; // https://api.github.com/repos/octocat/Hello-World/contents/{+path}
-    std::string contributors_url; // https://api.github.com/repos/octocat/Hello-World/contributors
-    std::string deployments_url; // https://api.github.com/repos/octocat/Hello-World/deployments
-    std::string downloads_url; // https://api.github.com/repos/octocat/Hello-World/downloads
-    std::string events_url; // https://api.github.com/repos/octocat/Hello-World/events
-    std::string forks_url; // https://api.github.com/repos/octocat/Hello-World/forks
-    std::string git_commits_url; // https://api.github.com/repos/octocat/Hello-World/git/commits{/sha}
-    std::string git_refs_url; // https://api.github.com/repos/octocat/Hello-World/git/refs{/sha}
-    std::string git_tags_url; // https://api.github.com/repos/octocat/Hello-World/git/tags{/sha}
     std::string git_url; // git:github.com/octocat/Hello-World.git
-    std::string issue_comment_url; // https://api.github.com/repos/octocat/Hello-World/issues/comments{/number}
-    std::string issue_events_url; // https://api.github.com/repos/octocat/Hello-World/issues/events{/number}
-    std::string issues_url; // https://api.github.com/repos/octocat/Hello-World/issues{/number}
-    std::string keys_url; // https://api.github.com/repos/octocat/Hello-World/keys{/key_id}
-    std::string labels_url; // https://api.github.com/repos/octocat/Hello-World/labels{/name}
-    std::string languages_url; // https://api.github.com/repos/octocat/Hello-World/languages
-    std::string merges_url; // https://api.github.com/repos/octocat/Hello-World/merges
-    std::string milestones_url; // https://api.github.com/repos/octocat/Hello-World/milestones{/number}
-    std::string notifications_url; // https://api.github.com/repos/octocat/Hello-World/notifications{?since,all,participating}
-    std::string pulls_url; // https://api.github.com/repos/octocat/Hello-World/pulls{/number}
-    std::string releases_url; // https://api.github.com/repos/octocat/Hello-World/releases{/id}
     std::string ssh_url; // git@github.com:octocat/Hello-World.git
-    std::string stargazers_url; // https://api.github.com/repos/octocat/Hello-World/stargazers
-    std::string statuses_url; // https://api.github.com/repos/octocat/Hello-World/statuses/{sha}
-    std::string subscribers_url; // https://api.github.com/repos/octocat/Hello-World/subscribers
-    std::string subscription_url; // https://api.github.com/repos/octocat/Hello-World/subscription
-    std::string tags_url; // https://api.github.com/repos/octocat/Hello-World/tags
-    std::string teams_url; // https://api.github.com/repos/octocat/Hello-World/teams
-    std::string trees_url; // https://api.github.com/repos/octocat/Hello-World/git/trees{/sha}
     std::string clone_url; // https://github.com/octocat/Hello-World.git
     std::string mirror_url; // git:git.example.com/octocat/Hello-World
-    std::string hooks_url; // https://api.github.com/repos/octocat/Hello-World/hooks
     std::string svn_url; // https://svn.github.com/octocat/Hello-World
     std::string homepage; // https://github.com
     std::string language;
@@ -122,21 +236,24 @@ public:
     std::string updated_at;
     std::string template_repository;
 
-    int forks_count;
-    int stargazers_count;
-    int watchers_count;
-    int size;
-    int id;
-    int open_issues_count;
-    int is_template;
-
-    bool isPrivate;
-    bool fork;
-    bool has_issues;
-    bool has_projects;
-    bool has_wiki;
-    bool has_pages;
-    bool has_downloads;
-    bool archived;
-    bool disabled;
+    int forks_count = 0;
+    int stargazers_count = 0;
+    int watchers_count = 0;
+    int size = 0;
+    int id = 0;
+    int open_issues_count = 0;
+    int is_template = 0;
+
+    bool isPrivate = false;
+    bool fork = false;
+    bool has_issues = false;
+    bool has_projects = false;
+    bool has_wiki = false;
+    bool has_pages = false;
+    bool has_downloads = false;
+    bool archived = false;
+    bool disabled = false;
+
+protected:
+    DerivedURLs urls;
 };
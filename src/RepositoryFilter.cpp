@@ -0,0 +1,407 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+#include "RepositoryFilter.h"
+#include "RepositoryTable.h"
+
+using namespace GitTools;
+
+namespace {
+    enum class Type { String, Date, Integer, Boolean };
+    enum class Op { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual, Contains };
+
+    /** One field an expression can name. Exactly one of the accessors is set. */
+    class FieldInfo {
+    public:
+        const char * name;
+        Type type;
+        Repository::Fields group;
+        const std::string & (*text)(const Repository &);
+        int64_t (*number)(const Repository &);
+        bool (*flag)(const Repository &);
+    };
+
+    #define TEXT(name, group, member) { name, Type::String, Repository::group, [](const Repository &r) -> const std::string & { return r.member; }, nullptr, nullptr }
+    #define DATE(name, member) { name, Type::Date, Repository::DateFields, [](const Repository &r) -> const std::string & { return r.member; }, nullptr, nullptr }
+    #define NUMBER(name, group, member) { name, Type::Integer, Repository::group, nullptr, [](const Repository &r) -> int64_t { return r.member; }, nullptr }
+    #define FLAG(name, group, member) { name, Type::Boolean, Repository::group, nullptr, nullptr, [](const Repository &r) -> bool { return r.member; } }
+
+    const FieldInfo fieldTable[] = {
+        TEXT("name", IdentityFields, name),
+        TEXT("full_name", IdentityFields, fullName),
+        TEXT("description", DescriptionFields, description),
+        TEXT("homepage", DescriptionFields, homepage),
+        TEXT("language", LanguageFields, language),
+        TEXT("visibility", VisibilityFields, visibility),
+        TEXT("default_branch", BranchFields, default_branch),
+        TEXT("owner", OwnerFields, owner.login),
+
+        DATE("pushed_at", pushed_at),
+        DATE("created_at", created_at),
+        DATE("updated_at", updated_at),
+
+        NUMBER("id", IdentityFields, id),
+        NUMBER("size", CountFields, size),
+        NUMBER("forks_count", CountFields, forks_count),
+        NUMBER("stargazers_count", CountFields, stargazers_count),
+        NUMBER("watchers_count", CountFields, watchers_count),
+        NUMBER("open_issues_count", CountFields, open_issues_count),
+
+        FLAG("archived", FlagFields, archived),
+        FLAG("disabled", FlagFields, disabled),
+        FLAG("fork", FlagFields, fork),
+        FLAG("is_template", FlagFields, is_template != 0),
+        FLAG("has_issues", FlagFields, has_issues),
+        FLAG("has_projects", FlagFields, has_projects),
+        FLAG("has_wiki", FlagFields, has_wiki),
+        FLAG("has_pages", FlagFields, has_pages),
+        FLAG("has_downloads", FlagFields, has_downloads),
+        FLAG("private", VisibilityFields, isPrivate),
+    };
+
+    #undef TEXT
+    #undef DATE
+    #undef NUMBER
+    #undef FLAG
+
+    std::string lower(const std::string &value) {
+        std::string rv = value;
+        for (char &c: rv) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return rv;
+    }
+
+    /** Case-insensitive compare, like strcasecmp but for std::string. */
+    int compareIgnoringCase(const std::string &a, const std::string &b) {
+        size_t length = std::min(a.size(), b.size());
+        for (size_t index = 0; index < length; ++index) {
+            int ca = std::tolower(static_cast<unsigned char>(a[index]));
+            int cb = std::tolower(static_cast<unsigned char>(b[index]));
+            if (ca != cb) {
+                return ca < cb ? -1 : 1;
+            }
+        }
+        return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+    }
+
+    template <class T>
+    bool compare(Op op, const T &a, const T &b) {
+        switch (op) {
+            case Op::Equal: return a == b;
+            case Op::NotEqual: return a != b;
+            case Op::Less: return a < b;
+            case Op::LessEqual: return a <= b;
+            case Op::Greater: return a > b;
+            case Op::GreaterEqual: return a >= b;
+            default: return false;
+        }
+    }
+}
+
+/**
+ * One node of the compiled expression.
+ */
+class GitTools::RepositoryFilter::Node {
+public:
+    enum class Kind { And, Or, Not, Compare };
+
+    bool matches(const Repository &repo) const;
+
+    Kind kind = Kind::Compare;
+    std::unique_ptr<Node> left;
+    std::unique_ptr<Node> right;
+
+    // For Compare. Dates are seconds since the epoch, in number.
+    const FieldInfo * field = nullptr;
+    Op op = Op::Equal;
+    std::string text;
+    int64_t number = 0;
+    bool flag = false;
+};
+
+bool RepositoryFilter::Node::matches(const Repository &repo) const {
+    switch (kind) {
+        case Kind::And: return left->matches(repo) && right->matches(repo);
+        case Kind::Or: return left->matches(repo) || right->matches(repo);
+        case Kind::Not: return !left->matches(repo);
+        case Kind::Compare: break;
+    }
+
+    switch (field->type) {
+        case Type::String:
+            if (op == Op::Contains) {
+                return lower(field->text(repo)).find(text) != std::string::npos;
+            }
+            return compare(op, compareIgnoringCase(field->text(repo), text), 0);
+
+        case Type::Date: {
+            int64_t when = 0;
+            return RepositoryTable::parseTimestamp(field->text(repo), when) && compare(op, when, number);
+        }
+
+        case Type::Integer:
+            return compare(op, field->number(repo), number);
+
+        case Type::Boolean:
+            return compare(op, field->flag(repo), flag);
+    }
+    return false;
+}
+
+//======================================================================
+// Parsing.
+//======================================================================
+
+namespace {
+    /**
+     * Recursive descent over
+     *
+     *     expr    := term ( "or" term )*
+     *     term    := factor ( "and" factor )*
+     *     factor  := "not" factor | "(" expr ")" | field op value
+     */
+    class Parser {
+    public:
+        Parser(const std::string &input, Repository::Fields &fields, std::vector<std::string> &compared)
+            : input(input), fields(fields), compared(compared) {}
+
+        std::unique_ptr<RepositoryFilter::Node> parse() {
+            std::unique_ptr<RepositoryFilter::Node> rv = expr();
+            skipSpace();
+            if (pos < input.size()) {
+                fail("unexpected text");
+            }
+            return rv;
+        }
+
+    protected:
+        typedef RepositoryFilter::Node Node;
+
+        std::unique_ptr<Node> combine(Node::Kind kind, std::unique_ptr<Node> left, std::unique_ptr<Node> right) {
+            std::unique_ptr<Node> node(new Node);
+            node->kind = kind;
+            node->left = std::move(left);
+            node->right = std::move(right);
+            return node;
+        }
+
+        std::unique_ptr<Node> expr() {
+            std::unique_ptr<Node> rv = term();
+            while (keyword("or")) {
+                rv = combine(Node::Kind::Or, std::move(rv), term());
+            }
+            return rv;
+        }
+
+        std::unique_ptr<Node> term() {
+            std::unique_ptr<Node> rv = factor();
+            while (keyword("and")) {
+                rv = combine(Node::Kind::And, std::move(rv), factor());
+            }
+            return rv;
+        }
+
+        std::unique_ptr<Node> factor() {
+            if (keyword("not")) {
+                return combine(Node::Kind::Not, factor(), nullptr);
+            }
+            skipSpace();
+            if (pos < input.size() && input[pos] == '(') {
+                ++pos;
+                std::unique_ptr<Node> rv = expr();
+                skipSpace();
+                if (pos >= input.size() || input[pos] != ')') {
+                    fail("missing )");
+                }
+                ++pos;
+                return rv;
+            }
+            return comparison();
+        }
+
+        std::unique_ptr<Node> comparison() {
+            size_t start = pos;
+            std::string name = identifier();
+            if (name.empty()) {
+                fail("expected a field name");
+            }
+
+            std::unique_ptr<Node> node(new Node);
+            for (const FieldInfo &info: fieldTable) {
+                if (name == info.name) {
+                    node->field = &info;
+                    break;
+                }
+            }
+            if (node->field == nullptr) {
+                pos = start;
+                fail("unknown field " + name);
+            }
+            fields |= node->field->group;
+            if (std::find(compared.begin(), compared.end(), name) == compared.end()) {
+                compared.push_back(name);
+            }
+
+            node->op = oper();
+            std::string value = literal();
+
+            switch (node->field->type) {
+                case Type::String:
+                    node->text = node->op == Op::Contains ? lower(value) : value;
+                    break;
+
+                case Type::Date:
+                    if (!RepositoryTable::parseTimestamp(value, node->number)) {
+                        fail("expected a date such as 2024-01-01 for " + name);
+                    }
+                    break;
+
+                case Type::Integer: {
+                    char *end = nullptr;
+                    node->number = std::strtoll(value.c_str(), &end, 10);
+                    if (value.empty() || *end != '\0') {
+                        fail("expected a number for " + name);
+                    }
+                    break;
+                }
+
+                case Type::Boolean: {
+                    std::string v = lower(value);
+                    if (v == "true" || v == "yes" || v == "1") {
+                        node->flag = true;
+                    }
+                    else if (v != "false" && v != "no" && v != "0") {
+                        fail("expected true or false for " + name);
+                    }
+                    break;
+                }
+            }
+
+            bool ordered = node->op != Op::Equal && node->op != Op::NotEqual;
+            if (node->op == Op::Contains && node->field->type != Type::String) {
+                fail("~ only works on text fields");
+            }
+            if (ordered && node->field->type == Type::Boolean) {
+                fail(name + " can only be compared with = or !=");
+            }
+            return node;
+        }
+
+        Op oper() {
+            skipSpace();
+            auto next = [&](const char *op) {
+                size_t length = strlen(op);
+                if (input.compare(pos, length, op) == 0) {
+                    pos += length;
+                    return true;
+                }
+                return false;
+            };
+
+            if (next("!=")) return Op::NotEqual;
+            if (next("<=")) return Op::LessEqual;
+            if (next(">=")) return Op::GreaterEqual;
+            if (next("==")) return Op::Equal;
+            if (next("=")) return Op::Equal;
+            if (next("<")) return Op::Less;
+            if (next(">")) return Op::Greater;
+            if (next("~")) return Op::Contains;
+            fail("expected one of = != < <= > >= ~");
+            return Op::Equal;
+        }
+
+        std::string identifier() {
+            skipSpace();
+            size_t start = pos;
+            while (pos < input.size() && (std::isalnum(static_cast<unsigned char>(input[pos])) || input[pos] == '_')) {
+                ++pos;
+            }
+            return input.substr(start, pos - start);
+        }
+
+        /** A quoted string, or everything up to whitespace or a closing paren. */
+        std::string literal() {
+            skipSpace();
+            if (pos < input.size() && (input[pos] == '"' || input[pos] == '\'')) {
+                char quote = input[pos++];
+                size_t end = input.find(quote, pos);
+                if (end == std::string::npos) {
+                    fail("unterminated string");
+                }
+                std::string rv = input.substr(pos, end - pos);
+                pos = end + 1;
+                return rv;
+            }
+
+            size_t start = pos;
+            while (pos < input.size() && !std::isspace(static_cast<unsigned char>(input[pos])) && input[pos] != ')') {
+                ++pos;
+            }
+            return input.substr(start, pos - start);
+        }
+
+        /** Consume this keyword if it's next, ignoring case. */
+        bool keyword(const char *word) {
+            skipSpace();
+            size_t length = strlen(word);
+            if (pos + length > input.size() || compareIgnoringCase(input.substr(pos, length), word) != 0) {
+                return false;
+            }
+            if (pos + length < input.size() && (std::isalnum(static_cast<unsigned char>(input[pos + length])) || input[pos + length] == '_')) {
+                return false;
+            }
+            pos += length;
+            return true;
+        }
+
+        void skipSpace() {
+            while (pos < input.size() && std::isspace(static_cast<unsigned char>(input[pos]))) {
+                ++pos;
+            }
+        }
+
+        [[noreturn]] void fail(const std::string &why) {
+            throw std::invalid_argument("--where: " + why + " at position " + std::to_string(pos + 1) + " of \"" + input + "\"");
+        }
+
+        const std::string &input;
+        Repository::Fields &fields;
+        std::vector<std::string> &compared;
+        size_t pos = 0;
+    };
+}
+
+//======================================================================
+// The filter.
+//======================================================================
+
+RepositoryFilter::RepositoryFilter(const std::string &expression) {
+    bool blank = true;
+    for (char c: expression) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            blank = false;
+            break;
+        }
+    }
+    if (!blank) {
+        root = Parser(expression, fields, compared).parse();
+    }
+}
+
+bool RepositoryFilter::matches(const Repository &repo) const {
+    return root == nullptr || root->matches(repo);
+}
+
+std::string RepositoryFilter::fieldNames() {
+    std::string rv;
+    for (const FieldInfo &info: fieldTable) {
+        if (!rv.empty()) {
+            rv += ", ";
+        }
+        rv += info.name;
+    }
+    return rv;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Repository.h"
+
+namespace GitTools {
+    class RepositoryFilter;
+}
+
+/**
+ * A compiled --where expression over Repository fields, such as
+ *
+ *     archived=false and language=Go and pushed_at<2024-01-01
+ *
+ * A comparison is field, operator, value. The operators are = != < <= > >= and ~
+ * (contains). Comparisons combine with and, or, not and parentheses. Values may be
+ * quoted with ' or " if they contain spaces or parentheses.
+ *
+ * String comparisons ignore case. Dates are GitHub timestamps (2024-01-01T12:00:00Z);
+ * a bare date means midnight UTC. A repo without the date never matches a comparison
+ * on it. Booleans are true/false, yes/no or 1/0.
+ *
+ * The expression is parsed and its values converted once, in the constructor, which
+ * throws std::invalid_argument if it can't make sense of it. An empty expression
+ * matches everything.
+ */
+class GitTools::RepositoryFilter
+{
+public:
+    class Node;
+
+    RepositoryFilter() = default;
+    RepositoryFilter(const std::string &expression);
+
+    bool matches(const Repository &repo) const;
+    bool empty() const { return root == nullptr; }
+
+    /** The field groups the expression looks at, for requesting a listing. */
+    Repository::Fields getFields() const { return fields; }
+
+    /** The names of the fields the expression compares, each once. */
+    const std::vector<std::string> & getComparedFields() const { return compared; }
+
+    /** The names matches() understands, for help text. */
+    static std::string fieldNames();
+
+protected:
+    std::shared_ptr<const Node> root = nullptr;
+    Repository::Fields fields = Repository::IdentityFields;
+    std::vector<std::string> compared;
+};
@@ -0,0 +1,210 @@
+#include <cstdio>
+
+#include "RepositoryTable.h"
+
+using namespace GitTools;
+
+namespace {
+    int64_t timestampOrNone(const std::string &value) {
+        int64_t seconds = 0;
+        return RepositoryTable::parseTimestamp(value, seconds) ? seconds : RepositoryTable::NoTimestamp;
+    }
+}
+
+//======================================================================
+// Bitmaps.
+//======================================================================
+
+RepositoryTable::Bitmap::Bitmap(size_t size, bool value)
+    : words((size + 63) / 64, value ? ~uint64_t(0) : 0), bits(size)
+{
+    trim();
+}
+
+void RepositoryTable::Bitmap::push_back(bool value) {
+    if (bits % 64 == 0) {
+        words.push_back(0);
+    }
+    ++bits;
+    set(bits - 1, value);
+}
+
+void RepositoryTable::Bitmap::set(size_t row, bool value) {
+    uint64_t bit = uint64_t(1) << (row % 64);
+    if (value) {
+        words[row / 64] |= bit;
+    }
+    else {
+        words[row / 64] &= ~bit;
+    }
+}
+
+size_t RepositoryTable::Bitmap::count() const {
+    size_t rv = 0;
+    for (uint64_t word: words) {
+        rv += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return rv;
+}
+
+/**
+ * Both bitmaps should come from the same table. If not, rows past the end of
+ * the shorter one count as clear.
+ */
+RepositoryTable::Bitmap & RepositoryTable::Bitmap::operator&=(const Bitmap &other) {
+    for (size_t index = 0; index < words.size(); ++index) {
+        words[index] &= index < other.words.size() ? other.words[index] : 0;
+    }
+    return *this;
+}
+
+RepositoryTable::Bitmap & RepositoryTable::Bitmap::operator|=(const Bitmap &other) {
+    for (size_t index = 0; index < words.size() && index < other.words.size(); ++index) {
+        words[index] |= other.words[index];
+    }
+    trim();
+    return *this;
+}
+
+RepositoryTable::Bitmap RepositoryTable::Bitmap::operator~() const {
+    Bitmap rv = *this;
+    for (uint64_t &word: rv.words) {
+        word = ~word;
+    }
+    rv.trim();
+    return rv;
+}
+
+/**
+ * Keep the bits past the end clear so count() needn't worry about them.
+ */
+void RepositoryTable::Bitmap::trim() {
+    if (bits % 64 != 0 && !words.empty()) {
+        words.back() &= (uint64_t(1) << (bits % 64)) - 1;
+    }
+}
+
+//======================================================================
+// Dictionary-encoded strings.
+//======================================================================
+
+RepositoryTable::DictionaryColumn::DictionaryColumn()
+    : values{ std::string{} }
+{
+    lookup.emplace(std::string{}, 0);
+}
+
+void RepositoryTable::DictionaryColumn::push_back(const std::string &value) {
+    auto it = lookup.find(value);
+    if (it == lookup.end()) {
+        it = lookup.emplace(value, static_cast<uint32_t>(values.size())).first;
+        values.push_back(value);
+    }
+    codes.push_back(it->second);
+}
+
+int RepositoryTable::DictionaryColumn::find(const std::string &value) const {
+    auto it = lookup.find(value);
+    return it != lookup.end() ? static_cast<int>(it->second) : -1;
+}
+
+//======================================================================
+// The table.
+//======================================================================
+
+RepositoryTable::RepositoryTable(const Repository::Vector &vec) {
+    add(vec);
+}
+
+/**
+ * Build directly from a listing. Only one page of Repository objects is held at a time.
+ */
+RepositoryTable::RepositoryTable(const Paginated<Repository> &listing) {
+    add(listing);
+}
+
+void RepositoryTable::add(const Repository &repo) {
+    names.push_back(repo.name);
+    ids.push_back(repo.id);
+
+    language.push_back(repo.language);
+    visibility.push_back(repo.visibility);
+    defaultBranch.push_back(repo.default_branch);
+
+    sizes.push_back(repo.size);
+    openIssues.push_back(repo.open_issues_count);
+    forks.push_back(repo.forks_count);
+    stargazers.push_back(repo.stargazers_count);
+
+    pushedAt.push_back(timestampOrNone(repo.pushed_at));
+    createdAt.push_back(timestampOrNone(repo.created_at));
+    updatedAt.push_back(timestampOrNone(repo.updated_at));
+
+    archived.push_back(repo.archived);
+    disabled.push_back(repo.disabled);
+    isPrivate.push_back(repo.isPrivate);
+    isFork.push_back(repo.fork);
+    isTemplate.push_back(repo.is_template != 0);
+    hasIssues.push_back(repo.has_issues);
+    hasWiki.push_back(repo.has_wiki);
+}
+
+void RepositoryTable::add(const Repository::Vector &vec) {
+    for (const Repository::Pointer &repo: vec) {
+        add(*repo);
+    }
+}
+
+void RepositoryTable::add(const Paginated<Repository> &listing) {
+    listing.forEachPage([this](const Repository::Vector &page) {
+        add(page);
+        return true;
+    });
+}
+
+/**
+ * We look the value up once and then compare codes.
+ */
+RepositoryTable::Bitmap RepositoryTable::select(const DictionaryColumn &column, const std::string &value) const {
+    int code = column.find(value);
+    if (code < 0) {
+        return Bitmap(column.size(), false);
+    }
+    uint32_t wanted = static_cast<uint32_t>(code);
+    return select(column.codes, [wanted](uint32_t c) { return c == wanted; });
+}
+
+std::vector<size_t> RepositoryTable::countBy(const DictionaryColumn &column, const Bitmap &rows) const {
+    std::vector<size_t> rv(column.values.size(), 0);
+    rows.forEach([&](size_t row) { ++rv[column.codes[row]]; });
+    return rv;
+}
+
+int64_t RepositoryTable::sum(const std::vector<int> &column, const Bitmap &rows) const {
+    int64_t rv = 0;
+    rows.forEach([&](size_t row) { rv += column[row]; });
+    return rv;
+}
+
+/**
+ * Also accepts a bare date (2011-01-26), which is midnight UTC.
+ */
+bool RepositoryTable::parseTimestamp(const std::string &value, int64_t &seconds) {
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (std::sscanf(value.c_str(), "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second) < 3
+        || month < 1 || month > 12 || day < 1 || day > 31)
+    {
+        return false;
+    }
+
+    // Days from 1970-01-01 in the proleptic Gregorian calendar.
+    int y = month <= 2 ? year - 1 : year;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yearOfEra = y - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = static_cast<int64_t>(era) * 146097 + dayOfEra - 719468;
+
+    seconds = days * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Paginated.h"
+#include "Repository.h"
+
+namespace GitTools {
+    class RepositoryTable;
+}
+
+/**
+ * The repos of a listing stored by column rather than by object, for reports that
+ * filter and count across thousands of repos. Each Repository is a couple of KB
+ * spread over dozens of strings; here a question like "how many archived Go repos"
+ * is a loop over a bitmap and an array of small integers.
+ *
+ *     RepositoryTable table(server.repositories(orgName));
+ *     RepositoryTable::Bitmap rows = table.archived;
+ *     rows &= table.select(table.language, "Go");
+ *     cout << rows.count() << endl;
+ *
+ * Row N of every column is the Nth repo added.
+ *
+ * This is a library facility for reporting programs of your own. GitTool doesn't build
+ * one: --where and the listings filter each page's Repository objects as they arrive,
+ * and several --where fields (description, owner, has_projects, ...) have no column.
+ */
+class GitTools::RepositoryTable
+{
+public:
+    /** One bit per row. */
+    class Bitmap {
+    public:
+        Bitmap() = default;
+        Bitmap(size_t size, bool value);
+
+        void push_back(bool value);
+        bool get(size_t row) const { return (words[row / 64] >> (row % 64)) & 1; }
+        void set(size_t row, bool value);
+        size_t size() const { return bits; }
+
+        /** How many rows are set. */
+        size_t count() const;
+
+        Bitmap & operator&=(const Bitmap &other);
+        Bitmap & operator|=(const Bitmap &other);
+        Bitmap operator~() const;
+
+        /** Call f(row) for each set row, in order. */
+        template <class F>
+        void forEach(F f) const {
+            for (size_t index = 0; index < words.size(); ++index) {
+                for (uint64_t word = words[index]; word != 0; word &= word - 1) {
+                    f(index * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+                }
+            }
+        }
+
+    protected:
+        void trim();
+
+        std::vector<uint64_t> words;
+        size_t bits = 0;
+    };
+
+    /**
+     * A string column stored as small integer codes into a list of distinct values.
+     * Code 0 is always the empty string.
+     */
+    class DictionaryColumn {
+    public:
+        DictionaryColumn();
+
+        void push_back(const std::string &value);
+        const std::string & operator[](size_t row) const { return values[codes[row]]; }
+        size_t size() const { return codes.size(); }
+
+        /** The code for this value, or -1 if no row has it. */
+        int find(const std::string &value) const;
+
+        std::vector<uint32_t> codes;
+        std::vector<std::string> values;
+
+    protected:
+        std::unordered_map<std::string, uint32_t> lookup;
+    };
+
+    RepositoryTable() = default;
+    RepositoryTable(const Repository::Vector &vec);
+    RepositoryTable(const Paginated<Repository> &listing);
+
+    void add(const Repository &repo);
+    void add(const Repository::Vector &vec);
+    void add(const Paginated<Repository> &listing);
+
+    size_t size() const { return names.size(); }
+    bool empty() const { return names.empty(); }
+
+    /** Rows whose column holds this value. */
+    Bitmap select(const DictionaryColumn &column, const std::string &value) const;
+
+    /** Rows for which pred(column[row]) is true. */
+    template <class T, class Pred>
+    Bitmap select(const std::vector<T> &column, Pred pred) const {
+        Bitmap rv(column.size(), false);
+        for (size_t row = 0; row < column.size(); ++row) {
+            if (pred(column[row])) {
+                rv.set(row, true);
+            }
+        }
+        return rv;
+    }
+
+    /** How many of these rows have each value, indexed by code. */
+    std::vector<size_t> countBy(const DictionaryColumn &column, const Bitmap &rows) const;
+
+    /** Add up this column over these rows. */
+    int64_t sum(const std::vector<int> &column, const Bitmap &rows) const;
+
+    /** What a date column holds for a repo without that date. */
+    static constexpr int64_t NoTimestamp = INT64_MIN;
+
+    /**
+     * A GitHub timestamp (2011-01-26T19:01:12Z) in seconds since the epoch. Returns
+     * false if value isn't one, such as when it's empty.
+     */
+    static bool parseTimestamp(const std::string &value, int64_t &seconds);
+
+    //======================================================================
+    // Columns.
+    //======================================================================
+    std::vector<std::string> names;
+    std::vector<int> ids;
+
+    DictionaryColumn language;
+    DictionaryColumn visibility;
+    DictionaryColumn defaultBranch;
+
+    std::vector<int> sizes;
+    std::vector<int> openIssues;
+    std::vector<int> forks;
+    std::vector<int> stargazers;
+
+    /** Seconds since the epoch, or NoTimestamp. */
+    std::vector<int64_t> pushedAt;
+    std::vector<int64_t> createdAt;
+    std::vector<int64_t> updatedAt;
+
+    Bitmap archived;
+    Bitmap disabled;
+    Bitmap isPrivate;
+    Bitmap isFork;
+    Bitmap isTemplate;
+    Bitmap hasIssues;
+    Bitmap hasWiki;
+};
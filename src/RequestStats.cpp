@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <unordered_map>
+
+#include <showlib/CommonUsing.h>
+
+#include "RequestStats.h"
+
+using namespace GitTools;
+
+namespace {
+    /** Buckets per doubling. Below this many microseconds each bucket is one microsecond. */
+    constexpr size_t SubBuckets = 8;
+
+    /** Enough doublings of a microsecond for about 50 days. */
+    constexpr size_t BucketCount = SubBuckets * 40;
+
+    /** After one of these path segments, the next ones are names. */
+    const std::unordered_map<string, std::vector<string>> & placeholders() {
+        static const std::unordered_map<string, std::vector<string>> table = {
+            { "repos",         { "{owner}", "{repo}" } },
+            { "orgs",          { "{org}" } },
+            { "users",         { "{user}" } },
+            { "teams",         { "{team}" } },
+            { "branches",      { "{branch}" } },
+            { "collaborators", { "{user}" } },
+            { "members",       { "{user}" } },
+            { "memberships",   { "{user}" } },
+        };
+        return table;
+    }
+
+    string milliseconds(double seconds) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.1f", seconds * 1000.0);
+        return buffer;
+    }
+
+    string megabytes(long bytes) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.2f", static_cast<double>(bytes) / (1024.0 * 1024.0));
+        return buffer;
+    }
+}
+
+//======================================================================
+// Histograms.
+//======================================================================
+
+/**
+ * The first SubBuckets buckets are 0..7 microseconds. After that each doubling
+ * of the time gets SubBuckets buckets, picked by the bits after the top one.
+ */
+size_t RequestStats::Histogram::bucketFor(uint64_t micros) {
+    if (micros < SubBuckets) {
+        return static_cast<size_t>(micros);
+    }
+    int top = 63 - __builtin_clzll(micros);
+    size_t octave = static_cast<size_t>(top) - 2;
+    size_t sub = static_cast<size_t>(micros >> (top - 3)) & (SubBuckets - 1);
+    return std::min(octave * SubBuckets + sub, BucketCount - 1);
+}
+
+/**
+ * The middle of the bucket's range, in seconds.
+ */
+double RequestStats::Histogram::bucketMiddle(size_t bucket) {
+    if (bucket < SubBuckets) {
+        return static_cast<double>(bucket) / 1e6;
+    }
+    size_t octave = bucket / SubBuckets;
+    double width = std::ldexp(1.0, static_cast<int>(octave) - 1);
+    double low = static_cast<double>(SubBuckets + bucket % SubBuckets) * width;
+    return (low + width / 2.0) / 1e6;
+}
+
+void RequestStats::Histogram::add(double seconds) {
+    if (buckets.empty()) {
+        buckets.resize(BucketCount, 0);
+    }
+    seconds = std::max(seconds, 0.0);
+    ++buckets[bucketFor(static_cast<uint64_t>(seconds * 1e6))];
+    ++samples;
+    total += seconds;
+    largest = std::max(largest, seconds);
+}
+
+void RequestStats::Histogram::merge(const Histogram &other) {
+    if (other.buckets.empty()) {
+        return;
+    }
+    if (buckets.empty()) {
+        buckets.resize(BucketCount, 0);
+    }
+    for (size_t index = 0; index < BucketCount; ++index) {
+        buckets[index] += other.buckets[index];
+    }
+    samples += other.samples;
+    total += other.total;
+    largest = std::max(largest, other.largest);
+}
+
+/**
+ * Never more than the largest sample, so the top bucket's width doesn't
+ * make p99 of a few requests look worse than the slowest of them.
+ */
+double RequestStats::Histogram::percentile(double fraction) const {
+    if (samples == 0) {
+        return 0.0;
+    }
+    uint64_t wanted = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(samples)));
+    wanted = std::max<uint64_t>(wanted, 1);
+
+    uint64_t seen = 0;
+    for (size_t index = 0; index < buckets.size(); ++index) {
+        seen += buckets[index];
+        if (seen >= wanted) {
+            return std::min(bucketMiddle(index), largest);
+        }
+    }
+    return largest;
+}
+
+//======================================================================
+// Recording.
+//======================================================================
+
+/**
+ * "GET /repos/{owner}/{repo}/branches/{branch}/protection" for
+ * /repos/foo/bar/branches/main/protection?x=y, with or without the host.
+ */
+std::string RequestStats::endpointFor(const std::string &method, const std::string &url) {
+    size_t start = 0;
+    size_t scheme = url.find("://");
+    if (scheme != string::npos) {
+        start = url.find('/', scheme + 3);
+        if (start == string::npos) {
+            return method + " /";
+        }
+    }
+    string path = url.substr(start, url.find('?', start) - start);
+
+    string rv = method + " ";
+    std::istringstream segments(path);
+    const std::vector<string> *names = nullptr;
+    size_t nameIndex = 0;
+
+    for (string segment; std::getline(segments, segment, '/'); ) {
+        if (segment.empty()) {
+            continue;
+        }
+        rv += "/";
+        if (names != nullptr && nameIndex < names->size()) {
+            rv += (*names)[nameIndex++];
+            continue;
+        }
+
+        rv += segment;
+        auto it = placeholders().find(segment);
+        names = it != placeholders().end() ? &it->second : nullptr;
+        nameIndex = 0;
+    }
+    return rv;
+}
+
+void RequestStats::record(const std::string &method, const std::string &url, const HTTPClient::Response &response) {
+    string key = endpointFor(method, url);
+    const HTTPClient::Timing &timing = response.timing;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Endpoint &endpoint = endpoints[key];
+
+    ++endpoint.requests;
+    ++endpoint.statuses[response.status];
+    if (response.status >= 400) {
+        ++endpoint.errors;
+    }
+    endpoint.bytesSent += timing.bytesSent;
+    endpoint.bytesReceived += timing.bytesReceived;
+
+    endpoint.total.add(timing.total);
+    endpoint.queue.add(timing.queue);
+    endpoint.dns.add(timing.dns);
+    endpoint.connect.add(timing.connect);
+    endpoint.tls.add(timing.tls);
+    endpoint.wait.add(timing.wait);
+    endpoint.transfer.add(timing.transfer);
+}
+
+/**
+ * A request that never got a response, such as one that couldn't connect.
+ */
+void RequestStats::recordFailure(const std::string &method, const std::string &url) {
+    string key = endpointFor(method, url);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Endpoint &endpoint = endpoints[key];
+    ++endpoint.requests;
+    ++endpoint.errors;
+    ++endpoint.statuses[0];
+}
+
+void RequestStats::recordParse(const std::string &method, const std::string &url, double seconds) {
+    string key = endpointFor(method, url);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    endpoints[key].parse.add(seconds);
+}
+
+RequestStats::EndpointMap RequestStats::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return endpoints;
+}
+
+RequestStats::Endpoint RequestStats::totals() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Endpoint rv;
+
+    for (const auto & [key, endpoint]: endpoints) {
+        rv.requests += endpoint.requests;
+        rv.errors += endpoint.errors;
+        for (const auto & [status, count]: endpoint.statuses) {
+            rv.statuses[status] += count;
+        }
+        rv.bytesSent += endpoint.bytesSent;
+        rv.bytesReceived += endpoint.bytesReceived;
+        rv.total.merge(endpoint.total);
+        rv.queue.merge(endpoint.queue);
+        rv.dns.merge(endpoint.dns);
+        rv.connect.merge(endpoint.connect);
+        rv.tls.merge(endpoint.tls);
+        rv.wait.merge(endpoint.wait);
+        rv.transfer.merge(endpoint.transfer);
+        rv.parse.merge(endpoint.parse);
+    }
+    return rv;
+}
+
+void RequestStats::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    endpoints.clear();
+}
+
+//======================================================================
+// Reporting.
+//======================================================================
+
+/**
+ * Times are in milliseconds. The phase columns are means; parse is the mean
+ * time to decode a page.
+ */
+void RequestStats::report(std::ostream &out) const {
+    EndpointMap copy = snapshot();
+    Endpoint all = totals();
+
+    size_t width = 8;
+    for (const auto & [key, endpoint]: copy) {
+        width = std::max(width, key.size());
+    }
+
+    auto row = [&](const string &name, const Endpoint &endpoint) {
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "%-*s %6zu %5zu %8s %8s %8s %8s %7s %7s %7s %7s %8s %8s %7s %8s",
+            static_cast<int>(width), name.c_str(), endpoint.requests, endpoint.errors,
+            milliseconds(endpoint.total.percentile(0.50)).c_str(),
+            milliseconds(endpoint.total.percentile(0.95)).c_str(),
+            milliseconds(endpoint.total.percentile(0.99)).c_str(),
+            milliseconds(endpoint.total.max()).c_str(),
+            milliseconds(endpoint.queue.mean()).c_str(),
+            milliseconds(endpoint.dns.mean()).c_str(),
+            milliseconds(endpoint.connect.mean()).c_str(),
+            milliseconds(endpoint.tls.mean()).c_str(),
+            milliseconds(endpoint.wait.mean()).c_str(),
+            milliseconds(endpoint.transfer.mean()).c_str(),
+            milliseconds(endpoint.parse.mean()).c_str(),
+            megabytes(endpoint.bytesReceived).c_str());
+        out << buffer << "\n";
+    };
+
+    char header[256];
+    snprintf(header, sizeof(header), "%-*s %6s %5s %8s %8s %8s %8s %7s %7s %7s %7s %8s %8s %7s %8s",
+        static_cast<int>(width), "endpoint", "count", "err", "p50", "p95", "p99", "max",
+        "queue", "dns", "connect", "tls", "wait", "transfer", "parse", "MB in");
+    out << header << "\n";
+
+    for (const auto & [key, endpoint]: copy) {
+        row(key, endpoint);
+    }
+    row("total", all);
+
+    out << "Statuses:";
+    for (const auto & [status, count]: all.statuses) {
+        out << " " << (status == 0 ? string{"failed"} : std::to_string(status)) << " x" << count;
+    }
+    out << ". " << milliseconds(all.total.sum()) << " ms in requests, "
+        << milliseconds(all.parse.sum()) << " ms decoding, "
+        << megabytes(all.bytesReceived) << " MB in, " << megabytes(all.bytesSent) << " MB out." << std::endl;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "HTTPClient.h"
+
+namespace GitTools {
+    class RequestStats;
+}
+
+/**
+ * Where the time goes, per endpoint. Server records every request here: its phase
+ * timings, bytes and status, and for listings how long the caller took to decode
+ * each page. Endpoints are the method and path with the names taken out, such as
+ * "GET /repos/{owner}/{repo}/branches/{branch}/protection".
+ *
+ *     server.getRepositories(orgName);
+ *     for (const auto & [endpoint, stats]: server.getStats().snapshot()) {
+ *         cout << endpoint << ": " << stats.total.percentile(0.95) << "s p95" << endl;
+ *     }
+ *
+ * All methods may be called from several threads.
+ */
+class GitTools::RequestStats
+{
+public:
+    /**
+     * Durations in log-spaced buckets, 8 per doubling, so percentiles are within
+     * about 6% without keeping every sample.
+     */
+    class Histogram {
+    public:
+        void add(double seconds);
+        void merge(const Histogram &other);
+
+        size_t count() const { return samples; }
+        double sum() const { return total; }
+        double max() const { return largest; }
+        double mean() const { return samples > 0 ? total / static_cast<double>(samples) : 0.0; }
+
+        /** The duration below which this fraction (0.5, 0.95 ...) of samples fall. */
+        double percentile(double fraction) const;
+
+    protected:
+        static size_t bucketFor(uint64_t micros);
+        static double bucketMiddle(size_t bucket);
+
+        std::vector<uint64_t> buckets;
+        size_t samples = 0;
+        double total = 0.0;
+        double largest = 0.0;
+    };
+
+    /** Everything we know about one endpoint. */
+    class Endpoint {
+    public:
+        size_t requests = 0;
+
+        /** Requests that failed to connect or had a status of 400 or more. */
+        size_t errors = 0;
+
+        std::map<long, size_t> statuses;
+        long bytesSent = 0;
+        long bytesReceived = 0;
+
+        Histogram total;
+        Histogram queue;
+        Histogram dns;
+        Histogram connect;
+        Histogram tls;
+        Histogram wait;
+        Histogram transfer;
+
+        /** Time spent decoding pages, for listings. */
+        Histogram parse;
+    };
+
+    typedef std::map<std::string, Endpoint> EndpointMap;
+
+    void record(const std::string &method, const std::string &url, const HTTPClient::Response &response);
+    void recordFailure(const std::string &method, const std::string &url);
+    void recordParse(const std::string &method, const std::string &url, double seconds);
+
+    /** A copy of what we have so far. */
+    EndpointMap snapshot() const;
+
+    /** All endpoints together. */
+    Endpoint totals() const;
+
+    void clear();
+
+    /** A table of percentiles and totals per endpoint. */
+    void report(std::ostream &out) const;
+
+    static std::string endpointFor(const std::string &method, const std::string &url);
+
+protected:
+    mutable std::mutex mutex;
+    EndpointMap endpoints;
+};
@@ -0,0 +1,139 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+#include <showlib/CommonUsing.h>
+#include <showlib/JSONSerializable.h>
+
+#include "ResponseCache.h"
+
+using namespace GitTools;
+
+namespace {
+    /**
+     * FNV-1a. We want file names that are stable from one run to the next, which std::hash doesn't promise.
+     */
+    uint64_t fnv1a(const std::string &value) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c: value) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    string hex(uint64_t value) {
+        char buffer[17];
+        snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+        return buffer;
+    }
+}
+
+/**
+ * Constructor. The directory is created if needed, readable only by us: entries hold
+ * whole responses, private repos and teams included.
+ */
+ResponseCache::ResponseCache(const std::string &dir)
+    : directory(dir)
+{
+    std::error_code error;
+    if (std::filesystem::create_directories(directory, error)) {
+        std::filesystem::permissions(directory, std::filesystem::perms::owner_all, std::filesystem::perm_options::replace, error);
+    }
+}
+
+/**
+ * Where we keep this url's entry.
+ */
+std::string ResponseCache::pathFor(const std::string &url, const std::string &identity) const {
+    return directory + "/" + hex(fnv1a(identity + "\n" + url)) + ".json";
+}
+
+/**
+ * Find the entry for this url. Returns false if we don't have one.
+ */
+bool ResponseCache::lookup(const std::string &url, const std::string &identity, Entry &entry) const {
+    std::ifstream input(pathFor(url, identity));
+    if (!input) {
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+
+    JSON json = JSON::parse(buffer.str(), nullptr, false);
+
+    // Guard against hash collisions and damaged files.
+    if (!json.is_object()
+        || ShowLib::JSONSerializable::stringValue(json, "url") != url
+        || ShowLib::JSONSerializable::stringValue(json, "identity") != hex(fnv1a(identity)))
+    {
+        return false;
+    }
+
+    entry.etag = ShowLib::JSONSerializable::stringValue(json, "etag");
+    entry.lastModified = ShowLib::JSONSerializable::stringValue(json, "last_modified");
+    entry.link = ShowLib::JSONSerializable::stringValue(json, "link");
+    entry.body = ShowLib::JSONSerializable::stringValue(json, "body");
+
+    return !entry.etag.empty() || !entry.lastModified.empty();
+}
+
+/**
+ * Save this entry. We write to a temporary file and rename it into place so
+ * readers never see a partial entry. Like the directory, it's for our eyes only.
+ * A body that isn't valid UTF-8 can't go in a JSON file, so we don't cache it;
+ * the fetch that brought it still succeeds.
+ */
+void ResponseCache::store(const std::string &url, const std::string &identity, const Entry &entry) const {
+    JSON json = JSON::object();
+
+    json["url"] = url;
+    json["identity"] = hex(fnv1a(identity));
+    json["etag"] = entry.etag;
+    json["last_modified"] = entry.lastModified;
+    json["link"] = entry.link;
+    json["body"] = entry.body;
+
+    string text;
+    try {
+        text = json.dump();
+    }
+    catch (const JSON::type_error &) {
+        return;
+    }
+
+    string path = pathFor(url, identity);
+    string tmpPath = path + "." + std::to_string(getpid())
+        + "." + hex(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+    {
+        std::ofstream output(tmpPath, std::ios::trunc);
+        if (!output) {
+            return;
+        }
+
+        // Before there's anything in it to see.
+        std::error_code error;
+        std::filesystem::permissions(tmpPath, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
+            std::filesystem::perm_options::replace, error);
+        if (error) {
+            output.close();
+            std::filesystem::remove(tmpPath, error);
+            return;
+        }
+        output << text;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmpPath, path, error);
+    if (error) {
+        std::filesystem::remove(tmpPath, error);
+    }
+}
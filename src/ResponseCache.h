@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+namespace GitTools {
+    class ResponseCache;
+}
+
+/**
+ * An on-disk cache of GET responses, used to make conditional requests. GitHub answers
+ * a matching If-None-Match / If-Modified-Since with 304 Not Modified, which is cheap
+ * and doesn't count against the rate limit, and we then serve the body from here.
+ *
+ * Entries are keyed by the url plus the identity we authenticate as, so two users
+ * sharing a cache directory never see each other's results. The identity may hold
+ * a token, so only a hash of it is written. Each entry is its own file, written
+ * atomically, so one cache may be shared by threads and processes.
+ */
+class GitTools::ResponseCache
+{
+public:
+    class Entry {
+    public:
+        std::string etag;
+        std::string lastModified;
+        std::string link;
+        std::string body;
+    };
+
+    ResponseCache(const std::string &directory);
+
+    const std::string & getDirectory() const { return directory; }
+
+    bool lookup(const std::string &url, const std::string &identity, Entry &entry) const;
+    void store(const std::string &url, const std::string &identity, const Entry &entry) const;
+
+    void recordHit() { ++hits; }
+    void recordMiss() { ++misses; }
+
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+
+protected:
+    std::string pathFor(const std::string &url, const std::string &identity) const;
+
+    std::string directory;
+    std::atomic<size_t> hits { 0 };
+    std::atomic<size_t> misses { 0 };
+};
@@ -1,10 +1,17 @@
-#include <iostream>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fnmatch.h>
+#include <mutex>
+#include <thread>
 
 #include <showlib/CommonUsing.h>
 #include <showlib/JSONSerializable.h>
 #include <showlib/StringUtils.h>
 
+#include "Log.h"
 #include "Server.h"
+#include "WorkerPool.h"
 
 using namespace GitTools;
 
@@ -16,105 +23,752 @@ Server::Server() {
     username = ShowLib::getEnv("GIT_USER", "git");
     apiToken = ShowLib::getEnv("GIT_TOKEN");
 
-    client.setHost( string{"https://"} + hostname);
+    string cacheDir = ShowLib::getEnv("GIT_CACHE_DIR");
+    if (!cacheDir.empty()) {
+        enableCache(cacheDir);
+    }
+
+    client.setHost(baseURL());
     client.setStandardHeader("Accept", "application/vnd.github+json");
     client.setStandardHeader("User-Agent", "curl/7.54.1");
     client.setStandardHeader("X-GitHub-Api-Version", "2022-11-28");
 }
 
-void Server::ensureHeaders() {
-    if (authHeader == nullptr && !username.empty() && !apiToken.empty()) {
-        authHeader = client.makeAuthHeader(username, apiToken);
-        client.pushStandardHeader(authHeader);
+/**
+ * Where requests go. GIT_HOST (or --host) may name its own scheme, such as
+ * http://localhost:8080 for a local stand-in server; otherwise it's https.
+ */
+std::string Server::baseURL() const {
+    if (hostname.compare(0, 7, "http://") == 0 || hostname.compare(0, 8, "https://") == 0) {
+        return hostname;
     }
+    return string{"https://"} + hostname;
 }
 
 /**
- * Retrieve repos for the authenticated user.
+ * Set up authentication on first use. Requests may come from several threads, so this only happens once.
+ * We pick up the host here too, in case it changed after construction.
  */
-Repository::Vector
-Server::getRepositories() {
-    Repository::Vector vec;
+void Server::ensureHeaders() {
+    std::call_once(authenticationOnce, [this] {
+        client.setHost(baseURL());
+        if (!username.empty() && !apiToken.empty()) {
+            client.setAuthentication(username, apiToken);
+        }
+    });
+}
+
+/**
+ * Keep GET responses in this directory and revalidate them with conditional requests.
+ */
+void Server::enableCache(const std::string &directory) {
+    cache = std::make_shared<ResponseCache>(directory);
+}
+
+/**
+ * Every request goes through here. We wait for the rate limiter to let us go, and if
+ * we're throttled anyway we wait out the Retry-After (or the reset) and try again.
+ */
+HTTPClient::Response Server::perform(
+        const std::string &method,
+        const std::string &url,
+        const std::string &body,
+        const HTTPClient::HeaderMap &headers)
+{
+    return perform(rateLimiter, method, url, body, headers);
+}
+
+/**
+ * The same, but counted against this budget.
+ */
+HTTPClient::Response Server::perform(
+        RateLimiter &limiter,
+        const std::string &method,
+        const std::string &url,
+        const std::string &body,
+        const HTTPClient::HeaderMap &headers)
+{
     ensureHeaders();
+    string endpoint = tracer.isEnabled() ? RequestStats::endpointFor(method, url) : string{};
+
+    for (int attempt = 1; ; ++attempt) {
+        Tracer::Clock::time_point waitStarted = Tracer::Clock::now();
+        if (limiter.acquire()) {
+            tracer.complete("rate limit wait", "ratelimit", waitStarted, Tracer::Clock::now(), { { "endpoint", endpoint } });
+        }
+
+        Tracer::Span span = tracer.span(endpoint, "http");
+        span.arg("endpoint", endpoint).arg("url", url).arg("attempt", attempt);
 
-    string url = "/user/repos?per_page=100";
-    int pageNum = 1;
-    while (true) {
-        cout << "Perform get on " << url << " and page " << pageNum << endl;
-        JSON json = client.get(url + "&page=" + std::to_string(pageNum));
-        ++pageNum;
+        HTTPClient::Response response;
+        try {
+            response = client.perform(method, url, body, headers);
+        }
+        catch (...) {
+            span.arg("failed", true);
+            limiter.cancel();
+            stats.recordFailure(method, url);
+            throw;
+        }
+        limiter.update(response);
+        stats.record(method, url, response);
+        span.arg("status", response.status).arg("bytes", response.timing.bytesReceived);
 
-        if (!json.is_array()) {
-            break;
+        if (attempt >= maxAttempts || !limiter.isThrottled(response)) {
+            return response;
         }
-        if (!json.size()) {
-            break;
+    }
+}
+
+/**
+ * Get our current rate limit budget from the server. Calling /rate_limit doesn't count against it.
+ */
+RateLimiter::Budget Server::refreshRateLimit() {
+    perform("GET", "/rate_limit", string{}, HTTPClient::HeaderMap{});
+    return rateLimiter.getBudget();
+}
+
+/**
+ * All our GETs come through here. If we're caching, we send the validators we have
+ * for this url, and on 304 Not Modified we hand back the cached body as a 200.
+ */
+HTTPClient::Response Server::get(const std::string &url) {
+    ensureHeaders();
+
+    if (cache == nullptr) {
+        return perform("GET", url, string{}, HTTPClient::HeaderMap{});
+    }
+
+    ResponseCache::Entry entry;
+    HTTPClient::HeaderMap headers;
+    bool haveEntry = conditionalHeaders(url, entry, headers);
+
+    HTTPClient::Response response = perform("GET", url, string{}, headers);
+    useCached(url, haveEntry, entry, response);
+    return response;
+}
+
+/**
+ * Before a cached GET: the validators for what we have. Returns whether we have anything.
+ */
+bool Server::conditionalHeaders(const std::string &url, ResponseCache::Entry &entry, HTTPClient::HeaderMap &headers) {
+    bool haveEntry = cache->lookup(url, username + ":" + apiToken, entry);
+
+    if (haveEntry && !entry.etag.empty()) {
+        headers["If-None-Match"] = entry.etag;
+    }
+    if (haveEntry && !entry.lastModified.empty()) {
+        headers["If-Modified-Since"] = entry.lastModified;
+    }
+    return haveEntry;
+}
+
+/**
+ * After a cached GET: on 304 swap in the body we have, and on 200 keep the new one.
+ */
+void Server::useCached(const std::string &url, bool haveEntry, ResponseCache::Entry &entry, HTTPClient::Response &response) {
+    if (haveEntry && response.status == 304) {
+        cache->recordHit();
+        response.status = 200;
+        response.body = std::move(entry.body);
+        if (response.header("link").empty() && !entry.link.empty()) {
+            response.headers["link"] = entry.link;
         }
+        return;
+    }
 
-        vec.fromJSON(json);
+    cache->recordMiss();
+    if (response.status == 200) {
+        entry.etag = response.header("etag");
+        entry.lastModified = response.header("last-modified");
+        if (!entry.etag.empty() || !entry.lastModified.empty()) {
+            entry.link = response.header("link");
+            entry.body = response.body;
+            cache->store(url, username + ":" + apiToken, entry);
+        }
     }
-    return vec;
+}
+
+/**
+ * Retrieve repos for the authenticated user.
+ */
+Repository::Vector
+Server::getRepositories(Repository::Fields fields) {
+    return repositories(fields).collect();
+}
+
+/**
+ * Retrieve repos for the named org.
+ */
+Repository::Vector Server::getRepositories(const OwnerName & orgName, Repository::Fields fields) {
+    return repositories(orgName, fields).collect();
 }
 
 /**
  * Retrieve teams for the named org.
  */
 Team::Vector Server::getTeams( const OwnerName & orgName) {
-    Team::Vector vec;
+    return teams(orgName).collect();
+}
+
+/**
+ * Retrieve users for the named org.
+ */
+User::Vector Server::getUsers(const OwnerName & orgName) {
+    return users(orgName).collect();
+}
+
+/**
+ * Retrieve a single repo. Returns nullptr if it doesn't exist (or we can't see it,
+ * which GitHub also answers with a 404). Any other failure throws.
+ */
+Repository::Pointer Server::getRepository(const OwnerName & orgName, const RepositoryName & repoName) {
+    string url = "/repos/" + orgName.get() + "/" + repoName.get();
+    HTTPClient::Response response = get(url);
+    if (response.status == 404) {
+        return nullptr;
+    }
+    checkReply("GET " + url, response);
+
+    Repository::Pointer repo = std::make_shared<Repository>();
+    repo->fromJSON(response.json());
+    return repo;
+}
+
+/**
+ * Is this login a member of the org? GitHub answers 204 if so and 404 if not. If we
+ * aren't a member ourselves we get a 302 to the public membership check instead.
+ * Anything else throws.
+ */
+bool Server::isOrgMember(const OwnerName & orgName, const UserName & login) {
+    string url = "/orgs/" + orgName.get() + "/members/" + login.get();
+    HTTPClient::Response response = get(url);
+    if (response.status == 302) {
+        url = "/orgs/" + orgName.get() + "/public_members/" + login.get();
+        response = get(url);
+    }
+    if (response.status == 404) {
+        return false;
+    }
+    checkReply("GET " + url, response);
+    return true;
+}
+
+/**
+ * Stream the repos for the authenticated user.
+ */
+Paginated<Repository> Server::repositories(Repository::Fields fields) {
+    return pages<Repository>(userRepositoriesURL(), repositoryPrepare(fields));
+}
+
+/**
+ * Stream the repos for the named org, most recently updated first.
+ */
+Paginated<Repository> Server::repositories(const OwnerName & orgName, Repository::Fields fields) {
+    return pages<Repository>(repositoriesURL(orgName), repositoryPrepare(fields));
+}
+
+/**
+ * Decode only these fields of each repo. Repositories start out with AllFields.
+ */
+Paginated<Repository>::Prepare Server::repositoryPrepare(Repository::Fields fields) {
+    if (fields == Repository::AllFields) {
+        return nullptr;
+    }
+    return [fields](Repository &repo) { repo.fields = fields; };
+}
+
+/**
+ * Stream the teams for the named org.
+ */
+Paginated<Team> Server::teams(const OwnerName & orgName) {
+    return pages<Team>(teamsURL(orgName));
+}
+
+/**
+ * Stream the members of the named org.
+ */
+Paginated<User> Server::users(const OwnerName & orgName) {
+    return pages<User>(usersURL(orgName));
+}
+
+std::string Server::userRepositoriesURL() {
+    return "/user/repos?per_page=100";
+}
+
+std::string Server::repositoriesURL(const OwnerName & orgName) {
+    return "/orgs/" + orgName.get() + "/repos?per_page=100&sort=updated&direction=desc";
+}
+
+std::string Server::teamsURL(const OwnerName & orgName) {
+    return "/orgs/" + orgName.get() + "/teams?per_page=100";
+}
+
+std::string Server::usersURL(const OwnerName & orgName) {
+    return "/orgs/" + orgName.get() + "/members?per_page=100";
+}
+
+/**
+ * Get one page of a paginated listing. The url must already contain a query string.
+ * Throws if the server still says no after our retries, so that a listing is never
+ * quietly cut short.
+ */
+HTTPClient::Response Server::getPage(const std::string &url, int pageNum) {
+    if (Log::instance().isEnabled(Log::Level::Debug)) {
+        Log::debug("Perform get on " + url + " and page " + std::to_string(pageNum));
+    }
+    HTTPClient::Response response = get(url + "&page=" + std::to_string(pageNum));
+    checkReply("GET " + url + " page " + std::to_string(pageNum), response);
+    return response;
+}
+
+/**
+ * Throw unless the reply is a success, saying what we asked and GitHub's message.
+ */
+void Server::checkReply(const std::string &request, const HTTPClient::Response &response) {
+    if (response.isSuccess()) {
+        return;
+    }
+    string msg = request + ": " + std::to_string(response.status);
+    string message = ShowLib::JSONSerializable::stringValue(response.json(), "message");
+    if (!message.empty()) {
+        msg += " " + message;
+    }
+    throw std::runtime_error(msg);
+}
+
+/**
+ * Walk every page of this listing, handing each one's body to the callback in page
+ * order. We don't parse the pages here -- that's up to the callback, which can stream
+ * them straight into objects. An empty page marks the end of the listing, and an
+ * error reply throws. The callback may return false to stop early.
+ *
+ * With pageWorkers == 1 we walk the pages one at a time until we see an empty one.
+ * Otherwise we read page 1, find the last page from the Link header (or probe for it),
+ * and fetch the rest concurrently, reading at most a few pages ahead of the callback.
+ */
+void Server::forEachPage(const std::string &url, const PageCallback &consumer) {
     ensureHeaders();
 
-    string url = "/orgs/" + orgName.get() + "/teams?per_page=100";
-    int pageNum = 1;
-    while (true) {
-        cout << "Perform get on " << url << " and page " << pageNum << endl;
-        JSON json = client.get(url + "&page=" + std::to_string(pageNum));
-        ++pageNum;
+    // What the consumer does with a page is mostly decoding it, so we count its time as parse time.
+    string endpoint = tracer.isEnabled() ? RequestStats::endpointFor("GET", url) : string{};
+    int pageNum = 0;
+    auto callback = [&](std::string &body) {
+        Tracer::Span span = tracer.span("decode", "decode");
+        span.arg("endpoint", endpoint).arg("page", ++pageNum).arg("bytes", body.size());
+
+        auto started = std::chrono::steady_clock::now();
+        bool rv = consumer(body);
+        stats.recordParse("GET", url, std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+        return rv;
+    };
+
+    HTTPClient::Response first = getPage(url, 1);
+    if (!isListingPage(first.body)) {
+        return;
+    }
+
+    int lastPage = HTTPClient::lastPageFromLink(first.header("link"));
+    if (!callback(first.body)) {
+        return;
+    }
+
+    if (pageWorkers <= 1) {
+        for (int pageNum = 2; lastPage == 0 || pageNum <= lastPage; ++pageNum) {
+            std::string body = std::move(getPage(url, pageNum).body);
+            if (!isListingPage(body) || !callback(body)) {
+                break;
+            }
+        }
+        return;
+    }
+
+    std::map<int, std::string> ready;
+    if (lastPage == 0) {
+        lastPage = probeLastPage(url, ready);
+    }
+    if (lastPage <= 1) {
+        return;
+    }
+
+    // Workers fetch pages 2..lastPage into ready. We deliver them from this thread,
+    // in order, and the workers stay no more than readAhead pages in front of us.
+    // A page that fails sets failed, which wakes everyone: the workers parked
+    // behind the read-ahead window give up, and so do we.
+    const int readAhead = pageWorkers * 2;
+    int nextToDeliver = 2;
+    bool stopping = false;
+    bool failed = false;
+    bool fetchDone = false;
+    std::exception_ptr fetchError = nullptr;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    auto fail = [&](std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fetchError == nullptr) {
+            fetchError = error;
+        }
+        failed = true;
+        changed.notify_all();
+    };
+
+    std::thread fetcher([&]() {
+        try {
+            WorkerPool(pageWorkers).run(lastPage - 1, [&](size_t index) {
+                int pageNum = static_cast<int>(index) + 2;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&] { return stopping || failed || pageNum < nextToDeliver + readAhead; });
+                    if (stopping || failed || pageNum < nextToDeliver || ready.count(pageNum) > 0) {
+                        return;
+                    }
+                }
+
+                try {
+                    std::string body = std::move(getPage(url, pageNum).body);
 
-        if (!json.is_array()) {
-            break;
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ready[pageNum] = std::move(body);
+                    changed.notify_all();
+                }
+                catch (...) {
+                    fail(std::current_exception());
+                }
+            });
         }
-        if (!json.size()) {
-            break;
+        catch (...) {
+            // Starting a thread can throw.
+            fail(std::current_exception());
         }
 
-        vec.fromJSON(json);
+        std::lock_guard<std::mutex> lock(mutex);
+        fetchDone = true;
+        changed.notify_all();
+    });
+
+    std::exception_ptr callbackError = nullptr;
+    std::string body;
+    try {
+        while (nextToDeliver <= lastPage) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return fetchDone || failed || ready.count(nextToDeliver) > 0; });
+
+            auto it = ready.find(nextToDeliver);
+            if (failed || it == ready.end()) {
+                break;
+            }
+            body = std::move(it->second);
+            ready.erase(it);
+            ++nextToDeliver;
+            changed.notify_all();
+            lock.unlock();
+
+            // The listing may have shrunk while we were reading it.
+            if (!isListingPage(body) || !callback(body)) {
+                break;
+            }
+        }
+    }
+    catch (...) {
+        callbackError = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        changed.notify_all();
     }
+    fetcher.join();
 
-    return vec;
+    if (callbackError != nullptr) {
+        std::rethrow_exception(callbackError);
+    }
+    if (fetchError != nullptr) {
+        std::rethrow_exception(fetchError);
+    }
 }
 
 /**
- * Retrieve users for the named org.
+ * We have no Link header, so find the last non-empty page by doubling until we hit an
+ * empty page and then bisecting. Any non-empty pages we read along the way are kept
+ * in probed so they needn't be fetched again. Returns 1 if page 1 was a short page.
  */
-User::Vector Server::getUsers(const OwnerName & orgName) {
-    User::Vector vec;
+int Server::probeLastPage(const std::string &url, std::map<int, std::string> &probed) {
+    int low = 1;
+    int high = 2;
+
+    auto hasData = [&](int pageNum) {
+        std::string body = std::move(getPage(url, pageNum).body);
+        bool rv = isListingPage(body);
+        if (rv) {
+            probed[pageNum] = std::move(body);
+        }
+        return rv;
+    };
+
+    while (hasData(high)) {
+        low = high;
+        high *= 2;
+    }
+
+    // low has data, high does not.
+    while (high - low > 1) {
+        int mid = low + (high - low) / 2;
+        if (hasData(mid)) {
+            low = mid;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Is this body a non-empty JSON array? We only look at the first couple of characters,
+ * so it's cheap. An empty array or an empty body is the end of a listing; getPage has
+ * already thrown for an error reply.
+ */
+bool Server::isListingPage(const std::string &body) {
+    size_t pos = body.find_first_not_of(" \t\r\n");
+    if (pos == std::string::npos || body[pos] != '[') {
+        return false;
+    }
+    pos = body.find_first_not_of(" \t\r\n", pos + 1);
+    return pos != std::string::npos && body[pos] != ']';
+}
+
+//======================================================================
+// GraphQL.
+//======================================================================
+
+namespace {
+    /** One page of an org's repos with their protection rules. */
+    const char * const protectedRepositoriesQuery = R"(
+query($org: String!, $cursor: String) {
+  organization(login: $org) {
+    repositories(first: 100, after: $cursor, orderBy: {field: NAME, direction: ASC}) {
+      pageInfo { hasNextPage endCursor }
+      nodes {
+        databaseId id name nameWithOwner url description homepageUrl
+        isArchived isDisabled isFork isPrivate isTemplate visibility
+        hasIssuesEnabled hasProjectsEnabled hasWikiEnabled
+        pushedAt createdAt updatedAt diskUsage forkCount stargazerCount
+        owner { __typename login id url ... on Organization { databaseId } ... on User { databaseId } }
+        issues(states: OPEN) { totalCount }
+        pullRequests(states: OPEN) { totalCount }
+        primaryLanguage { name }
+        defaultBranchRef { name }
+        branchProtectionRules(first: 100) {
+          nodes {
+            pattern isAdminEnforced allowsDeletions allowsForcePushes blocksCreations
+            lockBranch lockAllowsFetchAndMerge requiresLinearHistory
+            requiresConversationResolution requiresCommitSignatures restrictsPushes
+            requiresApprovingReviews requiredApprovingReviewCount dismissesStaleReviews
+            requiresCodeOwnerReviews requireLastPushApproval
+            requiresStatusChecks requiresStrictStatusChecks requiredStatusCheckContexts
+          }
+        }
+      }
+    }
+  }
+})";
+
+    using ShowLib::JSONSerializable;
+
+    /**
+     * Map a GraphQL Repository node onto our model. The REST urls aren't in the
+     * reply, so we build them. GraphQL has no has_pages or has_downloads; those
+     * stay false, and graphQLMissingFields() names them so callers can refuse a
+     * filter on them.
+     */
+    Repository::Pointer repositoryFromGraphQL(const JSON &node, const std::string &apiBase) {
+        Repository::Pointer repo = std::make_shared<Repository>();
+
+        repo->fields = Repository::IdentityFields | Repository::DescriptionFields | Repository::VisibilityFields
+            | Repository::BranchFields | Repository::FlagFields | Repository::CountFields
+            | Repository::DateFields | Repository::LanguageFields | Repository::OwnerFields;
+
+        repo->id = JSONSerializable::intValue(node, "databaseId");
+        repo->nodeId = JSONSerializable::stringValue(node, "id");
+        repo->name = JSONSerializable::stringValue(node, "name");
+        repo->fullName = JSONSerializable::stringValue(node, "nameWithOwner");
+        repo->html_url = JSONSerializable::stringValue(node, "url");
+        repo->url = apiBase + "/repos/" + repo->fullName;
+        repo->description = JSONSerializable::stringValue(node, "description");
+        repo->homepage = JSONSerializable::stringValue(node, "homepageUrl");
+
+        repo->visibility = ShowLib::toLower(JSONSerializable::stringValue(node, "visibility"));
+        repo->isPrivate = JSONSerializable::boolValue(node, "isPrivate");
+        repo->default_branch = JSONSerializable::stringValue(JSONSerializable::jsonValue(node, "defaultBranchRef"), "name");
+        repo->language = JSONSerializable::stringValue(JSONSerializable::jsonValue(node, "primaryLanguage"), "name");
+
+        repo->archived = JSONSerializable::boolValue(node, "isArchived");
+        repo->disabled = JSONSerializable::boolValue(node, "isDisabled");
+        repo->fork = JSONSerializable::boolValue(node, "isFork");
+        repo->is_template = JSONSerializable::boolValue(node, "isTemplate") ? 1 : 0;
+        repo->has_issues = JSONSerializable::boolValue(node, "hasIssuesEnabled");
+        repo->has_projects = JSONSerializable::boolValue(node, "hasProjectsEnabled");
+        repo->has_wiki = JSONSerializable::boolValue(node, "hasWikiEnabled");
+
+        repo->pushed_at = JSONSerializable::stringValue(node, "pushedAt");
+        repo->created_at = JSONSerializable::stringValue(node, "createdAt");
+        repo->updated_at = JSONSerializable::stringValue(node, "updatedAt");
+        repo->size = JSONSerializable::intValue(node, "diskUsage");
+        repo->forks_count = JSONSerializable::intValue(node, "forkCount");
+        repo->stargazers_count = JSONSerializable::intValue(node, "stargazerCount");
+
+        // REST's watchers_count is the star count, and its open_issues_count includes pull requests.
+        repo->watchers_count = repo->stargazers_count;
+        repo->open_issues_count = JSONSerializable::intValue(JSONSerializable::jsonValue(node, "issues"), "totalCount")
+            + JSONSerializable::intValue(JSONSerializable::jsonValue(node, "pullRequests"), "totalCount");
+
+        JSON owner = JSONSerializable::jsonValue(node, "owner");
+        repo->owner.login = JSONSerializable::stringValue(owner, "login");
+        repo->owner.nodeId = JSONSerializable::stringValue(owner, "id");
+        repo->owner.id = JSONSerializable::intValue(owner, "databaseId");
+        repo->owner.type = JSONSerializable::stringValue(owner, "__typename");
+        repo->owner.htmlURL = JSONSerializable::stringValue(owner, "url");
+        if (!repo->owner.login.empty()) {
+            repo->owner.setURL(apiBase + "/users/" + repo->owner.login);
+        }
+
+        return repo;
+    }
+}
+
+/**
+ * GraphQL's Repository has no Pages or downloads flags.
+ */
+const std::vector<std::string> & Server::graphQLMissingFields() {
+    static const std::vector<std::string> names { "has_pages", "has_downloads" };
+    return names;
+}
+
+/**
+ * On github.com GraphQL is at api.github.com/graphql. GitHub Enterprise serves REST
+ * from https://HOST/api/v3 and GraphQL from https://HOST/api/graphql.
+ */
+std::string Server::graphQLURL() const {
+    const string suffix = "/api/v3";
+    string host = client.getHost();
+    if (host.size() > suffix.size() && host.compare(host.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        return host.substr(0, host.size() - suffix.size()) + "/api/graphql";
+    }
+    return "/graphql";
+}
+
+/**
+ * Run one GraphQL query and return its data. GraphQL reports most errors in the body
+ * with a 200, so we throw if there are errors and no data to go with them, or a
+ * top-level field came back null (as organization does for an unknown org).
+ */
+JSON Server::graphQL(const std::string &query, const JSON &variables) {
     ensureHeaders();
 
-    string url = "/orgs/" + orgName.get() + "/members?per_page=100";
-    int pageNum = 1;
-    while (true) {
-        cout << "Perform get on " << url << " and page " << pageNum << endl;
-        JSON json = client.get(url + "&page=" + std::to_string(pageNum));
-        ++pageNum;
+    JSON request = JSON::object();
+    request["query"] = query;
+    request["variables"] = variables;
 
-        if (!json.is_array()) {
-            break;
+    HTTPClient::Response response = perform(graphQLLimiter, "POST", graphQLURL(), request.dump(), HTTPClient::HeaderMap{});
+    JSON reply = response.json();
+    JSON data = ShowLib::JSONSerializable::jsonValue(reply, "data");
+
+    JSON errors = ShowLib::JSONSerializable::jsonArray(reply, "errors");
+    bool unresolved = data.is_null();
+    if (data.is_object()) {
+        for (const JSON &field: data) {
+            unresolved = unresolved || field.is_null();
+        }
+    }
+    if (!response.isSuccess() || (unresolved && !errors.empty()) || !reply.is_object()) {
+        string msg = "GraphQL request failed with status " + std::to_string(response.status);
+        for (const JSON &error: errors) {
+            msg += ": " + ShowLib::JSONSerializable::stringValue(error, "message");
         }
-        if (!json.size()) {
-            break;
+        if (errors.empty()) {
+            msg += ": " + ShowLib::JSONSerializable::stringValue(reply, "message");
         }
+        throw std::runtime_error(msg);
+    }
+    return data;
+}
+
+/**
+ * Walk an org's repos with their branch protection rules, 100 repos per request, in
+ * name order. That replaces a listing plus a getProtection per repo. We read up to
+ * 100 rules per repo.
+ */
+void Server::forEachProtectedRepository(const OwnerName & orgName, const ProtectedRepositoryCallback &callback) {
+    JSON variables = JSON::object();
+    variables["org"] = orgName.get();
+    variables["cursor"] = nullptr;
 
-        vec.fromJSON(json);
+    ensureHeaders();
+    string apiBase = client.getHost();
+
+    for (;;) {
+        JSON data = graphQL(protectedRepositoriesQuery, variables);
+        JSON repositories = ShowLib::JSONSerializable::jsonValue(
+            ShowLib::JSONSerializable::jsonValue(data, "organization"), "repositories");
+
+        for (const JSON &node: ShowLib::JSONSerializable::jsonArray(repositories, "nodes")) {
+            ProtectedRepository item;
+            item.repository = repositoryFromGraphQL(node, apiBase);
+
+            JSON rules = ShowLib::JSONSerializable::jsonValue(node, "branchProtectionRules");
+            for (const JSON &rule: ShowLib::JSONSerializable::jsonArray(rules, "nodes")) {
+                item.rules.emplace_back();
+                item.rules.back().fromGraphQL(rule);
+            }
+
+            if (!callback(item)) {
+                return;
+            }
+        }
+
+        JSON pageInfo = ShowLib::JSONSerializable::jsonValue(repositories, "pageInfo");
+        if (!ShowLib::JSONSerializable::boolValue(pageInfo, "hasNextPage")) {
+            return;
+        }
+        variables["cursor"] = ShowLib::JSONSerializable::stringValue(pageInfo, "endCursor");
     }
+}
+
+std::vector<Server::ProtectedRepository> Server::getProtectedRepositories(const OwnerName & orgName) {
+    std::vector<ProtectedRepository> rv;
+    forEachProtectedRepository(orgName, [&](const ProtectedRepository &item) {
+        rv.push_back(item);
+        return true;
+    });
+    return rv;
+}
 
-    return vec;
+/**
+ * GitHub matches patterns with fnmatch rules, where * doesn't cross a /.
+ */
+const BranchProtection * Server::ProtectedRepository::ruleFor(const std::string &branchName) const {
+    const BranchProtection * rv = nullptr;
+    for (const BranchProtection &rule: rules) {
+        if (rule.getName() == branchName) {
+            return &rule;
+        }
+        if (rv == nullptr && fnmatch(rule.getName().c_str(), branchName.c_str(), FNM_PATHNAME) == 0) {
+            rv = &rule;
+        }
+    }
+    return rv;
 }
 
 /**
  * curl -X PUT -d '{"permission": "admin"}' -s -u "$GITHUB_USER:$GITHUB_TOKEN"
  * 	 "https://api.github.com/repos/verbit-ai/CT-Agents/collaborators/vitac-brentn"
+ *
+ * GitHub answers 201 when it sends an invitation and 204 when the user already had access.
  */
-void Server::addUserToRepo(
+HTTPClient::Response Server::addUserToRepo(
         const OwnerName & orgName,
         const RepositoryName & repoName,
         const UserName & login,
@@ -127,46 +781,581 @@ void Server::addUserToRepo(
     JSON json = JSON::object();
     json["permission"] = permName.get();
 
-    client.put(url, json);
+    return perform("PUT", url, json.dump(), HTTPClient::HeaderMap{});
+}
+
+/**
+ * Add every user to every repo, running up to bulkWorkers PUTs at once. We return
+ * one result per pair, in repo-major order, and a failure doesn't stop the rest.
+ */
+std::vector<Server::CollaboratorResult> Server::addUsersToRepos(
+        const OwnerName & orgName,
+        const std::vector<RepositoryName> & repoNames,
+        const std::vector<UserName> & userNames,
+        const PermissionName & permName )
+{
+    std::vector<CollaboratorResult> results(repoNames.size() * userNames.size());
+    ensureHeaders();
+
+    WorkerPool(bulkWorkers).run(results.size(), [&](size_t index) {
+        CollaboratorResult &result = results[index];
+        const RepositoryName &repoName = repoNames[index / userNames.size()];
+        const UserName &login = userNames[index % userNames.size()];
+
+        result.repoName = repoName.get();
+        result.login = login.get();
+
+        Tracer::Span span = tracer.span("add collaborator", "bulk");
+        span.arg("item", index).arg("repo", result.repoName).arg("login", result.login);
+
+        try {
+            HTTPClient::Response response = addUserToRepo(orgName, repoName, login, permName);
+            result.status = response.status;
+            if (!response.isSuccess()) {
+                result.message = ShowLib::JSONSerializable::stringValue(response.json(), "message");
+            }
+        }
+        catch (const std::exception &e) {
+            result.message = e.what();
+        }
+    });
+
+    return results;
 }
 
 /**
  * /repos/{owner}/{repo}/branches/{branch}/protection
  */
 BranchProtection Server::getProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName) {
+    return readProtection(orgName, repoName, branchName).protection;
+}
+
+/**
+ * Read one branch's protection, keeping the status so callers can tell an
+ * unprotected branch from a failure.
+ */
+Server::ProtectionResult Server::readProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName) {
     string url = "/repos/" + orgName.get() + "/" + repoName.get() + "/branches/" + branchName.get() + "/protection";
-    BranchProtection bp;
+    ProtectionResult result;
+    result.repoName = repoName.get();
+    result.branchName = branchName.get();
 
     ensureHeaders();
 
-    JSON json = client.get(url);
-    bp.fromJSON(json);
+    HTTPClient::Response response = get(url);
+    JSON json = response.json();
+    result.status = response.status;
+    result.message = ShowLib::JSONSerializable::stringValue(json, "message");
+    result.protection.fromJSON(json);
 
-    return bp;
+    return result;
 }
 
-void Server::deleteProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName) {
+/**
+ * Read protection for each repo and branch, bulkWorkers at a time. Results are in
+ * the same order as targets. A request that throws is reported with status 0.
+ */
+std::vector<Server::ProtectionResult> Server::getProtections(const OwnerName & orgName, const std::vector<BranchTarget> & targets) {
+    std::vector<ProtectionResult> results(targets.size());
     ensureHeaders();
 
-    string url = "/repos/" + orgName.get() + "/" + repoName.get() + "/branches/" + branchName.get() + "/protection";
+    WorkerPool(bulkWorkers).run(targets.size(), [&](size_t index) {
+        const auto & [repoName, branchName] = targets[index];
+        Tracer::Span span = tracer.span("read protection", "bulk");
+        span.arg("item", index).arg("repo", repoName.get()).arg("branch", branchName.get());
+
+        try {
+            results[index] = readProtection(orgName, repoName, branchName);
+        }
+        catch (const std::exception &e) {
+            results[index].repoName = repoName.get();
+            results[index].branchName = branchName.get();
+            results[index].message = e.what();
+        }
+    });
+
+    return results;
+}
+
+namespace {
+    /** Streams the names out of a page of a branch listing. */
+    class BranchNameParser: public PageParser {
+    public:
+        BranchNameParser(std::vector<Server::BranchName> &names): names(names) {}
+
+    protected:
+        void beginElement() override {}
+        void endElement() override {}
+
+        void field(const std::string &section, const std::string &key, FieldValue &value) override {
+            if (section.empty() && key == "name") {
+                names.push_back(Server::BranchName(value.takeString()));
+            }
+        }
 
-    JSON body = nullptr;
-    client.del(url, body);
+        std::vector<Server::BranchName> &names;
+    };
 }
 
 /**
- * Set branch protection.
+ * The names of this repo's branches. A page we can't decode throws, as for the other listings.
  */
-void Server::setProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName, const UpdateBranchProtection &bp) {
+std::vector<Server::BranchName> Server::getBranchNames(const OwnerName & orgName, const RepositoryName & repoName) {
+    std::vector<BranchName> rv;
+    forEachPage("/repos/" + orgName.get() + "/" + repoName.get() + "/branches?per_page=100", [&](std::string &body) {
+        BranchNameParser(rv).decode(body);
+        return true;
+    });
+    return rv;
+}
+
+HTTPClient::Response Server::deleteProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName) {
     ensureHeaders();
 
     string url = "/repos/" + orgName.get() + "/" + repoName.get() + "/branches/" + branchName.get() + "/protection";
 
-    JSON body = bp.toJSON();
-    JSON reply = client.put(url, body);
+    return perform("DELETE", url, string{}, HTTPClient::HeaderMap{});
+}
+
+/**
+ * DELETE the protection of each target, bulkWorkers at a time. Results are in the same
+ * order and a failure doesn't stop the rest. A branch that was already unprotected comes
+ * back as 404 "Branch not protected", which isError() doesn't count.
+ */
+std::vector<Server::ProtectionResult> Server::deleteProtections(const OwnerName & orgName, const std::vector<BranchTarget> & targets) {
+    std::vector<ProtectionResult> results(targets.size());
+    ensureHeaders();
+
+    WorkerPool(bulkWorkers).run(targets.size(), [&](size_t index) {
+        ProtectionResult &result = results[index];
+        const auto & [repoName, branchName] = targets[index];
+
+        result.repoName = repoName.get();
+        result.branchName = branchName.get();
+
+        Tracer::Span span = tracer.span("delete protection", "bulk");
+        span.arg("item", index).arg("repo", result.repoName).arg("branch", result.branchName);
+
+        try {
+            HTTPClient::Response response = deleteProtection(orgName, repoName, branchName);
+            result.status = response.status;
+            if (!response.isSuccess()) {
+                result.message = ShowLib::JSONSerializable::stringValue(response.json(), "message");
+            }
+        }
+        catch (const std::exception &e) {
+            result.message = e.what();
+        }
+    });
+
+    return results;
+}
+
+/**
+ * Set branch protection.
+ */
+void Server::setProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName, const UpdateBranchProtection &bp) {
+    JSON reply = putProtection(orgName, repoName, branchName, bp).json();
     if ( ShowLib::JSONSerializable::hasKey(reply, "message") ) {
         string msg = ShowLib::JSONSerializable::stringValue(reply, "message");
         ShowLib::replaceAll(msg, "\\n", "\n");
-        cout << "Reply message: " << msg << endl;
+        Log::warning("Reply message: " + msg);
+    }
+}
+
+/**
+ * The PUT behind setProtection, leaving the reply to the caller.
+ */
+HTTPClient::Response Server::putProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName, const UpdateBranchProtection &bp) {
+    return putProtection(orgName, repoName, branchName, bp.toJSON());
+}
+
+/**
+ * The same with a body worked out earlier, such as one read back from a Plan.
+ */
+HTTPClient::Response Server::putProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName, const JSON &body) {
+    ensureHeaders();
+
+    string url = "/repos/" + orgName.get() + "/" + repoName.get() + "/branches/" + branchName.get() + "/protection";
+
+    return perform("PUT", url, body.dump(), HTTPClient::HeaderMap{});
+}
+
+/**
+ * PUT updates[i] to targets[i], bulkWorkers at a time. Results are in the same order
+ * and a failure doesn't stop the rest. On success the result holds what GitHub says
+ * the protection now is.
+ */
+std::vector<Server::ProtectionResult> Server::setProtections(
+        const OwnerName & orgName,
+        const std::vector<BranchTarget> & targets,
+        const std::vector<UpdateBranchProtection> & updates)
+{
+    std::vector<JSON> bodies;
+    bodies.reserve(updates.size());
+    for (const UpdateBranchProtection &update: updates) {
+        bodies.push_back(update.toJSON());
+    }
+    return setProtections(orgName, targets, bodies);
+}
+
+/**
+ * The same with bodies worked out earlier, such as those in a Plan.
+ */
+std::vector<Server::ProtectionResult> Server::setProtections(
+        const OwnerName & orgName,
+        const std::vector<BranchTarget> & targets,
+        const std::vector<JSON> & bodies)
+{
+    std::vector<ProtectionResult> results(targets.size());
+    ensureHeaders();
+
+    WorkerPool(bulkWorkers).run(targets.size(), [&](size_t index) {
+        ProtectionResult &result = results[index];
+        const auto & [repoName, branchName] = targets[index];
+
+        result.repoName = repoName.get();
+        result.branchName = branchName.get();
+
+        Tracer::Span span = tracer.span("set protection", "bulk");
+        span.arg("item", index).arg("repo", result.repoName).arg("branch", result.branchName);
+
+        try {
+            HTTPClient::Response response = putProtection(orgName, repoName, branchName, bodies[index]);
+            JSON json = response.json();
+            result.status = response.status;
+            if (response.isSuccess()) {
+                result.protection.fromJSON(json);
+            }
+            else {
+                result.message = ShowLib::JSONSerializable::stringValue(json, "message");
+            }
+        }
+        catch (const std::exception &e) {
+            result.message = e.what();
+        }
+    });
+
+    return results;
+}
+
+//======================================================================
+// Asynchronous calls.
+//======================================================================
+
+namespace {
+    /**
+     * A request the rate limiter holds back waits on the executor's timers. Finishing
+     * requests can free up budget before the limiter's estimate, so we look again at
+     * least this often.
+     */
+    constexpr std::chrono::milliseconds AsyncRetryInterval { 250 };
+}
+
+/**
+ * One request on its way through performAsync: what to send, which attempt this is,
+ * and since when it's been waiting for the rate limiter.
+ */
+class Server::AsyncRequest {
+public:
+    RateLimiter * limiter = nullptr;
+    std::string method;
+    std::string url;
+    std::string body;
+    HTTPClient::HeaderMap headers;
+    HTTPClient::Completion done;
+
+    int attempt = 1;
+    bool waiting = false;
+    Tracer::Clock::time_point waitingSince;
+};
+
+/**
+ * One listing being read by forEachPageAsync.
+ */
+class Server::PageWalk {
+public:
+    std::string url;
+    std::string endpoint;
+    AsyncPageCallback onPage;
+    AsyncDoneCallback onDone;
+
+    std::mutex mutex;
+
+    /** Page 1 had no Link header, so we ask for one page at a time. */
+    bool sequential = false;
+
+    /** Pages asked for and not yet handled. */
+    int pending = 0;
+    std::exception_ptr error = nullptr;
+};
+
+std::future<Repository::Vector> Server::getRepositoriesAsync(Repository::Fields fields) {
+    return collectAsync<Repository>(userRepositoriesURL(), repositoryPrepare(fields));
+}
+
+std::future<Repository::Vector> Server::getRepositoriesAsync(const OwnerName & orgName, Repository::Fields fields) {
+    return collectAsync<Repository>(repositoriesURL(orgName), repositoryPrepare(fields));
+}
+
+std::future<Team::Vector> Server::getTeamsAsync(const OwnerName & orgName) {
+    return collectAsync<Team>(teamsURL(orgName));
+}
+
+std::future<User::Vector> Server::getUsersAsync(const OwnerName & orgName) {
+    return collectAsync<User>(usersURL(orgName));
+}
+
+std::future<BranchProtection> Server::getProtectionAsync(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName) {
+    string url = "/repos/" + orgName.get() + "/" + repoName.get() + "/branches/" + branchName.get() + "/protection";
+    std::shared_ptr<std::promise<BranchProtection>> promise = std::make_shared<std::promise<BranchProtection>>();
+
+    getAsync(url, [promise](HTTPClient::Response &response, std::exception_ptr error) {
+        if (error != nullptr) {
+            promise->set_exception(error);
+            return;
+        }
+        try {
+            BranchProtection protection;
+            protection.fromJSON(response.json());
+            promise->set_value(protection);
+        }
+        catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+
+    return promise->get_future();
+}
+
+/**
+ * The PUT behind setProtection. Unlike setProtection, we leave the reply to the caller.
+ */
+std::future<HTTPClient::Response> Server::setProtectionAsync(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName, const UpdateBranchProtection &bp) {
+    string url = "/repos/" + orgName.get() + "/" + repoName.get() + "/branches/" + branchName.get() + "/protection";
+    return requestAsync("PUT", url, bp.toJSON().dump());
+}
+
+std::future<HTTPClient::Response> Server::addUserToRepoAsync(const OwnerName & orgName, const RepositoryName & repoName, const UserName & login, const PermissionName &permName) {
+    string url = "/repos/" + orgName.get() + "/" + repoName.get() + "/collaborators/" + login.get();
+
+    JSON json = JSON::object();
+    json["permission"] = permName.get();
+
+    return requestAsync("PUT", url, json.dump());
+}
+
+/**
+ * One request with a future for its response.
+ */
+std::future<HTTPClient::Response> Server::requestAsync(const std::string &method, const std::string &url, const std::string &body) {
+    std::shared_ptr<std::promise<HTTPClient::Response>> promise = std::make_shared<std::promise<HTTPClient::Response>>();
+
+    performAsync(rateLimiter, method, url, body, HTTPClient::HeaderMap{}, [promise](HTTPClient::Response &response, std::exception_ptr error) {
+        if (error != nullptr) {
+            promise->set_exception(error);
+        }
+        else {
+            promise->set_value(std::move(response));
+        }
+    });
+
+    return promise->get_future();
+}
+
+/**
+ * perform(), without blocking. Where perform() waits for the rate limiter, we ask
+ * the executor to try again later; where it retries a throttled request, we send
+ * it again from the completion.
+ */
+void Server::performAsync(
+        RateLimiter &limiter,
+        const std::string &method,
+        const std::string &url,
+        const std::string &body,
+        const HTTPClient::HeaderMap &headers,
+        const HTTPClient::Completion &done)
+{
+    ensureHeaders();
+
+    std::shared_ptr<AsyncRequest> request = std::make_shared<AsyncRequest>();
+    request->limiter = &limiter;
+    request->method = method;
+    request->url = url;
+    request->body = body;
+    request->headers = headers;
+    request->done = done;
+
+    performAsync(request);
+}
+
+void Server::performAsync(const std::shared_ptr<AsyncRequest> &request) {
+    RateLimiter::Clock::time_point retryAt;
+    if (!request->limiter->tryAcquire(retryAt)) {
+        if (!request->waiting) {
+            request->waiting = true;
+            request->waitingSince = Tracer::Clock::now();
+        }
+        auto delay = std::min<RateLimiter::Clock::duration>(retryAt - RateLimiter::Clock::now(), AsyncRetryInterval);
+        client.getExecutor().post([this, request]() { performAsync(request); },
+            std::chrono::duration_cast<IOExecutor::Clock::duration>(std::max(delay, RateLimiter::Clock::duration::zero())));
+        return;
+    }
+
+    string endpoint = tracer.isEnabled() ? RequestStats::endpointFor(request->method, request->url) : string{};
+    if (request->waiting) {
+        tracer.completeAsync("rate limit wait", "ratelimit", request->waitingSince, Tracer::Clock::now(), { { "endpoint", endpoint } });
+        request->waiting = false;
+    }
+
+    Tracer::Clock::time_point started = Tracer::Clock::now();
+    auto completion = [this, request, endpoint, started](HTTPClient::Response &response, std::exception_ptr error) {
+        RateLimiter &limiter = *request->limiter;
+        JSON args = JSON::object();
+        if (tracer.isEnabled()) {
+            args = { { "endpoint", endpoint }, { "url", request->url }, { "attempt", request->attempt } };
+        }
+
+        if (error != nullptr) {
+            limiter.cancel();
+            stats.recordFailure(request->method, request->url);
+            args["failed"] = true;
+            tracer.completeAsync(endpoint, "http", started, Tracer::Clock::now(), args);
+            request->done(response, error);
+            return;
+        }
+
+        limiter.update(response);
+        stats.record(request->method, request->url, response);
+        args["status"] = response.status;
+        args["bytes"] = response.timing.bytesReceived;
+        tracer.completeAsync(endpoint, "http", started, Tracer::Clock::now(), args);
+
+        if (request->attempt < maxAttempts && limiter.isThrottled(response)) {
+            ++request->attempt;
+            performAsync(request);
+            return;
+        }
+        request->done(response, nullptr);
+    };
+
+    try {
+        client.performAsync(request->method, request->url, request->body, request->headers, completion);
+    }
+    catch (...) {
+        request->limiter->cancel();
+        HTTPClient::Response none;
+        request->done(none, std::current_exception());
+    }
+}
+
+/**
+ * get(), without blocking.
+ */
+void Server::getAsync(const std::string &url, const HTTPClient::Completion &done) {
+    ensureHeaders();
+
+    if (cache == nullptr) {
+        performAsync(rateLimiter, "GET", url, string{}, HTTPClient::HeaderMap{}, done);
+        return;
     }
+
+    std::shared_ptr<ResponseCache::Entry> entry = std::make_shared<ResponseCache::Entry>();
+    HTTPClient::HeaderMap headers;
+    bool haveEntry = conditionalHeaders(url, *entry, headers);
+
+    performAsync(rateLimiter, "GET", url, string{}, headers, [this, url, haveEntry, entry, done](HTTPClient::Response &response, std::exception_ptr error) {
+        if (error == nullptr) {
+            useCached(url, haveEntry, *entry, response);
+        }
+        done(response, error);
+    });
+}
+
+/**
+ * forEachPage(), without blocking. We read page 1, and if its Link header says how
+ * many pages there are, ask for the rest at once; otherwise we go a page at a time
+ * until one comes back empty. Pages are handed over as they arrive, so not in order.
+ * Like forEachPage, an empty page ends the listing and an error reply fails it.
+ */
+void Server::forEachPageAsync(const std::string &url, const AsyncPageCallback &onPage, const AsyncDoneCallback &onDone) {
+    ensureHeaders();
+
+    std::shared_ptr<PageWalk> walk = std::make_shared<PageWalk>();
+    walk->url = url;
+    walk->endpoint = tracer.isEnabled() ? RequestStats::endpointFor("GET", url) : string{};
+    walk->onPage = onPage;
+    walk->onDone = onDone;
+    walk->pending = 1;
+
+    fetchPageAsync(walk, 1);
+}
+
+void Server::fetchPageAsync(const std::shared_ptr<PageWalk> &walk, int pageNum) {
+    if (Log::instance().isEnabled(Log::Level::Debug)) {
+        Log::debug("Perform get on " + walk->url + " and page " + std::to_string(pageNum));
+    }
+
+    getAsync(walk->url + "&page=" + std::to_string(pageNum), [this, walk, pageNum](HTTPClient::Response &response, std::exception_ptr error) {
+        int firstNew = 0;
+        int lastNew = -1;
+
+        if (error == nullptr) {
+            try {
+                checkReply("GET " + walk->url + " page " + std::to_string(pageNum), response);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        if (error == nullptr && isListingPage(response.body)) {
+            try {
+                Tracer::Span span = tracer.span("decode", "decode");
+                span.arg("endpoint", walk->endpoint).arg("page", pageNum).arg("bytes", response.body.size());
+
+                auto started = std::chrono::steady_clock::now();
+                walk->onPage(pageNum, response.body);
+                stats.recordParse("GET", walk->url, std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+
+                // Page 1 tells us what's left: every other page, or with no Link header, the next one.
+                if (pageNum == 1) {
+                    int lastPage = HTTPClient::lastPageFromLink(response.header("link"));
+                    walk->sequential = lastPage == 0;
+                    firstNew = 2;
+                    lastNew = lastPage;
+                }
+                if (walk->sequential) {
+                    firstNew = lastNew = pageNum + 1;
+                }
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        bool finished = false;
+        std::exception_ptr firstError = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(walk->mutex);
+            if (error != nullptr && walk->error == nullptr) {
+                walk->error = error;
+            }
+            if (walk->error == nullptr && lastNew >= firstNew) {
+                walk->pending += lastNew - firstNew + 1;
+            }
+            else {
+                lastNew = -1;
+            }
+            finished = --walk->pending == 0;
+            firstError = walk->error;
+        }
+
+        for (int next = firstNew; next <= lastNew; ++next) {
+            fetchPageAsync(walk, next);
+        }
+        if (finished) {
+            walk->onDone(firstError);
+        }
+    });
 }
@@ -1,15 +1,28 @@
 #pragma once
 
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <NamedType/named_type.hpp>
 
 #include <showlib/CommonUsing.h>
-#include <showlib/RESTClient.h>
 
 #include "BranchProtection.h"
+#include "HTTPClient.h"
+#include "IOExecutor.h"
+#include "Paginated.h"
+#include "RateLimiter.h"
+#include "RequestStats.h"
+#include "ResponseCache.h"
 #include "Repository.h"
 #include "Team.h"
+#include "Tracer.h"
 #include "User.h"
 
 namespace GitTools {
@@ -28,25 +41,241 @@ public:
     using UserName = fluent::NamedType<std::string, struct BranchNameType, fluent::Callable, fluent::Printable>;
     using PermissionName = fluent::NamedType<std::string, struct BranchNameType, fluent::Callable, fluent::Printable>;
 
+    /** Receives the body of each page of a listing. It may move the body away. */
+    typedef std::function<bool(std::string &)> PageCallback;
+
+    /** The outcome of one PUT from addUsersToRepos. */
+    class CollaboratorResult {
+    public:
+        std::string repoName;
+        std::string login;
+        long status = 0;
+        std::string message;
+
+        bool isSuccess() const { return status >= 200 && status < 300; }
+    };
+
+    /** One repo and branch, for the bulk protection calls. */
+    typedef std::pair<RepositoryName, BranchName> BranchTarget;
+
+    /** The outcome of one read from getProtections, one PUT from setProtections, or one DELETE from deleteProtections. */
+    class ProtectionResult {
+    public:
+        std::string repoName;
+        std::string branchName;
+        long status = 0;
+        std::string message;
+        BranchProtection protection;
+
+        bool isProtected() const { return status == 200; }
+
+        /** GitHub answers 404 "Branch not protected" for an unprotected branch. That isn't an error. */
+        bool isError() const { return status != 200 && !(status == 404 && message == "Branch not protected"); }
+    };
+
+    /** A repo and its branch protection rules, as read with GraphQL. */
+    class ProtectedRepository {
+    public:
+        Repository::Pointer repository;
+
+        /** One per rule. Each one's getName() is the rule's branch pattern, such as "main" or "release-*". */
+        std::vector<BranchProtection> rules;
+
+        /** The rule covering this branch, or nullptr. An exact pattern beats a wildcard. */
+        const BranchProtection * ruleFor(const std::string &branchName) const;
+    };
+
+    typedef std::function<bool(const ProtectedRepository &)> ProtectedRepositoryCallback;
+
     Server();
 
-    Repository::Vector getRepositories();
+    Repository::Vector getRepositories(Repository::Fields fields = Repository::AllFields);
+    Repository::Vector getRepositories(const OwnerName & orgName, Repository::Fields fields = Repository::AllFields);
     Team::Vector getTeams(const OwnerName & orgName);
     User::Vector getUsers(const OwnerName & orgName);
 
+    // Single-object lookups, for when we only need a few.
+    Repository::Pointer getRepository(const OwnerName & orgName, const RepositoryName & repoName);
+    bool isOrgMember(const OwnerName & orgName, const UserName & login);
+
+    // Streaming versions of the above.
+    Paginated<Repository> repositories(Repository::Fields fields = Repository::AllFields);
+    Paginated<Repository> repositories(const OwnerName & orgName, Repository::Fields fields = Repository::AllFields);
+    Paginated<Team> teams(const OwnerName & orgName);
+    Paginated<User> users(const OwnerName & orgName);
+
+    void forEachPage(const std::string &url, const PageCallback &callback);
+
+    // GraphQL. These read a whole org in pages of 100 repos, protection rules included.
+    JSON graphQL(const std::string &query, const JSON &variables);
+    void forEachProtectedRepository(const OwnerName & orgName, const ProtectedRepositoryCallback &callback);
+    std::vector<ProtectedRepository> getProtectedRepositories(const OwnerName & orgName);
+
+    /** The REST repo fields GraphQL has no equivalent for, which the repos above leave unset. */
+    static const std::vector<std::string> & graphQLMissingFields();
+
     BranchProtection getProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName & branchName);
+    std::vector<ProtectionResult> getProtections(const OwnerName & orgName, const std::vector<BranchTarget> & targets);
+    std::vector<BranchName> getBranchNames(const OwnerName & orgName, const RepositoryName & repoName);
     void setProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName, const UpdateBranchProtection &);
-    void deleteProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName);
-    void addUserToRepo(const OwnerName & orgName, const RepositoryName & repoName, const UserName & userName, const PermissionName &perm);
+    HTTPClient::Response putProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName, const UpdateBranchProtection &);
+    HTTPClient::Response putProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName, const JSON &body);
+    std::vector<ProtectionResult> setProtections(
+        const OwnerName & orgName,
+        const std::vector<BranchTarget> & targets,
+        const std::vector<UpdateBranchProtection> & updates);
+    std::vector<ProtectionResult> setProtections(
+        const OwnerName & orgName,
+        const std::vector<BranchTarget> & targets,
+        const std::vector<JSON> & bodies);
+    HTTPClient::Response deleteProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName);
+    std::vector<ProtectionResult> deleteProtections(const OwnerName & orgName, const std::vector<BranchTarget> & targets);
+    HTTPClient::Response addUserToRepo(const OwnerName & orgName, const RepositoryName & repoName, const UserName & userName, const PermissionName &perm);
+    std::vector<CollaboratorResult> addUsersToRepos(
+        const OwnerName & orgName,
+        const std::vector<RepositoryName> & repoNames,
+        const std::vector<UserName> & userNames,
+        const PermissionName &perm);
+
+    // Asynchronous versions, for many calls at once without a thread for each. They return
+    // at once and the requests run on the I/O executor, through the same rate limiter, cache,
+    // stats and tracer as the rest. A future throws whatever the blocking call would have.
+    // The Server must outlive its futures.
+    std::future<Repository::Vector> getRepositoriesAsync(Repository::Fields fields = Repository::AllFields);
+    std::future<Repository::Vector> getRepositoriesAsync(const OwnerName & orgName, Repository::Fields fields = Repository::AllFields);
+    std::future<Team::Vector> getTeamsAsync(const OwnerName & orgName);
+    std::future<User::Vector> getUsersAsync(const OwnerName & orgName);
+    std::future<BranchProtection> getProtectionAsync(const OwnerName & orgName, const RepositoryName & repoName, const BranchName & branchName);
+    std::future<HTTPClient::Response> setProtectionAsync(const OwnerName & orgName, const RepositoryName & repoName, const BranchName &branchName, const UpdateBranchProtection &);
+    std::future<HTTPClient::Response> addUserToRepoAsync(const OwnerName & orgName, const RepositoryName & repoName, const UserName & userName, const PermissionName &perm);
+
+    /** Where the asynchronous calls run. IOExecutor::shared() unless set. */
+    Server & setExecutor(IOExecutor &executor) { client.setExecutor(&executor); return *this; }
+    IOExecutor & getExecutor() const { return client.getExecutor(); }
+
+    /** How many pages of a listing we fetch at once. 1 means one page at a time. */
+    int getPageWorkers() const { return pageWorkers; }
+    Server & setPageWorkers(int value) { pageWorkers = value > 0 ? value : 1; return *this; }
+
+    /** How many requests the bulk operations run at once. */
+    int getBulkWorkers() const { return bulkWorkers; }
+    Server & setBulkWorkers(int value) { bulkWorkers = value > 0 ? value : 1; return *this; }
+
+    /** Cache GET responses here. Also enabled by setting GIT_CACHE_DIR. */
+    void enableCache(const std::string &directory);
+
+    /** The response cache, or nullptr if not caching. It holds the hit/miss counters. */
+    const ResponseCache * getCache() const { return cache.get(); }
+
+    /** What we know of our rate limit budget from recent responses. */
+    RateLimiter::Budget getRateLimit() const { return rateLimiter.getBudget(); }
+    RateLimiter::Budget refreshRateLimit();
+    RateLimiter & getRateLimiter() { return rateLimiter; }
+
+    /** Timings, sizes and statuses of every request so far, per endpoint. */
+    const RequestStats & getStats() const { return stats; }
+    RequestStats & getStats() { return stats; }
+
+    /** Spans for requests, page decodes, bulk items and rate limit waits, once enabled. */
+    const Tracer & getTracer() const { return tracer; }
+    Tracer & getTracer() { return tracer; }
+
+    /** GraphQL has its own budget, counted in query points rather than requests. */
+    RateLimiter::Budget getGraphQLRateLimit() const { return graphQLLimiter.getBudget(); }
 
     std::string		hostname;
     std::string		username;
     std::string		apiToken;
 
 protected:
+    class AsyncRequest;
+    class PageWalk;
+
+    /** Gets each page's number and body as it arrives, in any order, on the executor's thread. */
+    typedef std::function<void(int pageNum, std::string &body)> AsyncPageCallback;
+
+    /** Called once every page is in, with the first error if there was one. */
+    typedef std::function<void(std::exception_ptr error)> AsyncDoneCallback;
+
     void ensureHeaders();
 
-    ShowLib::RESTClient		client;
-    ShowLib::RESTClient::HTTPHeader::Pointer	authHeader = nullptr;
+    HTTPClient::Response perform(const std::string &method, const std::string &url, const std::string &body, const HTTPClient::HeaderMap &headers);
+    HTTPClient::Response perform(RateLimiter &limiter, const std::string &method, const std::string &url, const std::string &body, const HTTPClient::HeaderMap &headers);
+    std::string baseURL() const;
+    std::string graphQLURL() const;
+    ProtectionResult readProtection(const OwnerName & orgName, const RepositoryName & repoName, const BranchName & branchName);
+    HTTPClient::Response get(const std::string &url);
+    bool conditionalHeaders(const std::string &url, ResponseCache::Entry &entry, HTTPClient::HeaderMap &headers);
+    void useCached(const std::string &url, bool haveEntry, ResponseCache::Entry &entry, HTTPClient::Response &response);
+    HTTPClient::Response getPage(const std::string &url, int pageNum);
+    static void checkReply(const std::string &request, const HTTPClient::Response &response);
+    int probeLastPage(const std::string &url, std::map<int, std::string> &probed);
+    static bool isListingPage(const std::string &body);
+
+    /** A lazy listing of T read from this paginated url. */
+    template <class T>
+    Paginated<T> pages(const std::string &url, typename Paginated<T>::Prepare prepare = nullptr) {
+        return Paginated<T>( [this, url](const PageCallback &callback) { forEachPage(url, callback); }, prepare );
+    }
+
+    static Paginated<Repository>::Prepare repositoryPrepare(Repository::Fields fields);
+    static std::string userRepositoriesURL();
+    static std::string repositoriesURL(const OwnerName & orgName);
+    static std::string teamsURL(const OwnerName & orgName);
+    static std::string usersURL(const OwnerName & orgName);
+
+    void performAsync(RateLimiter &limiter, const std::string &method, const std::string &url, const std::string &body,
+        const HTTPClient::HeaderMap &headers, const HTTPClient::Completion &done);
+    void performAsync(const std::shared_ptr<AsyncRequest> &request);
+    void getAsync(const std::string &url, const HTTPClient::Completion &done);
+    std::future<HTTPClient::Response> requestAsync(const std::string &method, const std::string &url, const std::string &body);
+    void forEachPageAsync(const std::string &url, const AsyncPageCallback &onPage, const AsyncDoneCallback &onDone);
+    void fetchPageAsync(const std::shared_ptr<PageWalk> &walk, int pageNum);
+
+    /** Read a whole listing of T asynchronously, decoding each page as it arrives. */
+    template <class T>
+    std::future<typename T::Vector> collectAsync(const std::string &url, typename Paginated<T>::Prepare prepare = nullptr) {
+        typedef typename T::Vector Vector;
+
+        std::shared_ptr<std::promise<Vector>> promise = std::make_shared<std::promise<Vector>>();
+        std::shared_ptr<std::map<int, Vector>> pages = std::make_shared<std::map<int, Vector>>();
+        std::shared_ptr<std::mutex> pagesMutex = std::make_shared<std::mutex>();
+
+        forEachPageAsync(url,
+            [pages, pagesMutex, prepare](int pageNum, std::string &body) {
+                Vector page;
+                StreamDecoder<T> decoder(page, prepare);
+                decoder.decode(body);
+
+                std::lock_guard<std::mutex> lock(*pagesMutex);
+                (*pages)[pageNum] = std::move(page);
+            },
+            [promise, pages](std::exception_ptr error) {
+                if (error != nullptr) {
+                    promise->set_exception(error);
+                    return;
+                }
+                Vector vec;
+                for (auto & [pageNum, page]: *pages) {
+                    vec.insert(vec.end(), page.begin(), page.end());
+                }
+                promise->set_value(std::move(vec));
+            });
+
+        return promise->get_future();
+    }
+
+    HTTPClient		client;
+    RateLimiter		rateLimiter;
+    RateLimiter		graphQLLimiter;
+    RequestStats	stats;
+    Tracer			tracer;
+    std::shared_ptr<ResponseCache> cache = nullptr;
+    std::once_flag	authenticationOnce;
+    int				pageWorkers = 1;
+    int				bulkWorkers = 4;
+
+    /** How many times we'll send a request that was throttled. */
+    int				maxAttempts = 3;
 };
 
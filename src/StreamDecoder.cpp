@@ -0,0 +1,202 @@
+#include <stdexcept>
+
+#include <showlib/CommonUsing.h>
+
+#include "StreamDecoder.h"
+
+using namespace GitTools;
+
+//======================================================================
+// Values.
+//======================================================================
+
+const std::string & FieldValue::peekString() const {
+    static const std::string empty;
+    return type == Type::String ? *str : empty;
+}
+
+int FieldValue::asInt() const {
+    switch (type) {
+        case Type::Integer: return static_cast<int>(integer);
+        case Type::Float: return static_cast<int>(real);
+        default: return 0;
+    }
+}
+
+//======================================================================
+// The parser.
+//======================================================================
+
+/**
+ * Parse this page. Returns false if it wasn't valid JSON or wasn't an array.
+ */
+bool PageParser::parse(const std::string &body) {
+    depth = 0;
+    skipDepth = 0;
+    error.clear();
+    return JSON::sax_parse(body, this);
+}
+
+/**
+ * Parse this page, and throw std::runtime_error if we can't. A listing that stopped
+ * quietly here would look complete.
+ */
+void PageParser::decode(const std::string &body) {
+    if (!parse(body)) {
+        throw std::runtime_error("Couldn't decode a page of the listing: " + error);
+    }
+}
+
+/**
+ * Deliver a scalar to wherever we are.
+ */
+bool PageParser::scalar(FieldValue value) {
+    if (skipDepth > 0) {
+        return true;
+    }
+
+    switch (depth) {
+        case 0:
+            // A bare scalar isn't a page.
+            error = "expected an array, not a scalar";
+            return false;
+
+        case 2:
+            field(std::string{}, elementKey, value);
+            break;
+
+        case 3:
+            if (inNestedArray) {
+                field(std::string{}, sectionKey, value);
+            }
+            else {
+                field(sectionKey, nestedKey, value);
+            }
+            break;
+
+        default:
+            break;
+    }
+    return true;
+}
+
+bool PageParser::null() {
+    return scalar(FieldValue(nullptr));
+}
+
+bool PageParser::boolean(bool val) {
+    return scalar(FieldValue(val));
+}
+
+bool PageParser::number_integer(number_integer_t val) {
+    return scalar(FieldValue(static_cast<int64_t>(val)));
+}
+
+bool PageParser::number_unsigned(number_unsigned_t val) {
+    return scalar(FieldValue(static_cast<int64_t>(val)));
+}
+
+bool PageParser::number_float(number_float_t val, const string_t &) {
+    return scalar(FieldValue(static_cast<double>(val)));
+}
+
+bool PageParser::string(string_t &val) {
+    return scalar(FieldValue(val));
+}
+
+bool PageParser::binary(binary_t &) {
+    return true;
+}
+
+bool PageParser::start_object(std::size_t) {
+    if (skipDepth > 0 || depth >= 3) {
+        ++skipDepth;
+        return true;
+    }
+
+    switch (depth) {
+        case 0:
+            // An object where we wanted an array: probably an error message.
+            error = "expected an array, not an object";
+            return false;
+
+        case 1:
+            beginElement();
+            depth = 2;
+            break;
+
+        case 2:
+            sectionKey = elementKey;
+            inNestedArray = false;
+            depth = 3;
+            break;
+    }
+    return true;
+}
+
+bool PageParser::key(string_t &val) {
+    if (skipDepth > 0) {
+        return true;
+    }
+    if (depth == 2) {
+        elementKey.swap(val);
+    }
+    else if (depth == 3) {
+        nestedKey.swap(val);
+    }
+    return true;
+}
+
+bool PageParser::end_object() {
+    if (skipDepth > 0) {
+        --skipDepth;
+        return true;
+    }
+
+    if (depth == 3) {
+        depth = 2;
+    }
+    else if (depth == 2) {
+        endElement();
+        depth = 1;
+    }
+    return true;
+}
+
+bool PageParser::start_array(std::size_t) {
+    if (skipDepth > 0 || depth == 1 || depth >= 3) {
+        ++skipDepth;
+        return true;
+    }
+
+    if (depth == 0) {
+        depth = 1;
+    }
+    else {
+        sectionKey = elementKey;
+        inNestedArray = true;
+        depth = 3;
+    }
+    return true;
+}
+
+bool PageParser::end_array() {
+    if (skipDepth > 0) {
+        --skipDepth;
+        return true;
+    }
+
+    if (depth == 3) {
+        inNestedArray = false;
+        depth = 2;
+    }
+    else if (depth == 1) {
+        depth = 0;
+    }
+    return true;
+}
+
+bool PageParser::parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &ex) {
+    error = ex.what();
+    return false;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <showlib/JSONSerializable.h>
+
+#include "PackedVector.h"
+
+namespace GitTools {
+    class FieldValue;
+    class PageParser;
+    template <class T> class StreamDecoder;
+    template <class T> class PackedDecoder;
+}
+
+/**
+ * One scalar from the JSON stream. Strings may be moved out with takeString(),
+ * so each one is only ever copied once, from the parser straight into the model.
+ */
+class GitTools::FieldValue
+{
+public:
+    enum class Type { Null, Boolean, Integer, Float, String };
+
+    FieldValue(std::nullptr_t): type(Type::Null) {}
+    FieldValue(bool value): type(Type::Boolean), boolean(value) {}
+    FieldValue(int64_t value): type(Type::Integer), integer(value) {}
+    FieldValue(double value): type(Type::Float), real(value) {}
+    FieldValue(std::string &value): type(Type::String), str(&value) {}
+
+    Type getType() const { return type; }
+    bool isNull() const { return type == Type::Null; }
+
+    /** Matches JSONSerializable: the wrong type reads as empty, 0 or false. */
+    std::string takeString() { return type == Type::String ? std::move(*str) : std::string{}; }
+    const std::string & peekString() const;
+    int asInt() const;
+    bool asBool() const { return type == Type::Boolean && boolean; }
+
+protected:
+    Type type;
+    bool boolean = false;
+    int64_t integer = 0;
+    double real = 0.0;
+    std::string * str = nullptr;
+};
+
+/**
+ * SAX parser for one page of a listing -- a JSON array of objects -- that never builds
+ * a DOM. For each element we call beginElement(), then field() for every scalar, and
+ * then endElement(). A scalar directly inside the element has an empty section; one
+ * inside a nested object (such as a repo's "owner") has that object's key as its
+ * section. Scalars inside an array (such as "topics") arrive one at a time under the
+ * array's key. Anything nested deeper than that is skipped.
+ */
+class GitTools::PageParser: public nlohmann::json_sax<JSON>
+{
+public:
+    bool parse(const std::string &body);
+    void decode(const std::string &body);
+
+    /** Why the last parse() failed. */
+    const std::string & getError() const { return error; }
+
+    bool null() override;
+    bool boolean(bool val) override;
+    bool number_integer(number_integer_t val) override;
+    bool number_unsigned(number_unsigned_t val) override;
+    bool number_float(number_float_t val, const string_t &s) override;
+    bool string(string_t &val) override;
+    bool binary(binary_t &val) override;
+    bool start_object(std::size_t elements) override;
+    bool key(string_t &val) override;
+    bool end_object() override;
+    bool start_array(std::size_t elements) override;
+    bool end_array() override;
+    bool parse_error(std::size_t position, const std::string &last_token, const nlohmann::detail::exception &ex) override;
+
+protected:
+    virtual void beginElement() = 0;
+    virtual void field(const std::string &section, const std::string &key, FieldValue &value) = 0;
+    virtual void endElement() = 0;
+
+    bool scalar(FieldValue value);
+
+    /** 0 = outside, 1 = in the page array, 2 = in an element, 3 = in a nested object or array. */
+    int depth = 0;
+
+    /** Nesting below depth 3 that we're ignoring. */
+    int skipDepth = 0;
+
+    std::string error;
+    std::string elementKey;
+    std::string sectionKey;
+    std::string nestedKey;
+    bool inNestedArray = false;
+};
+
+/**
+ * Decode a page straight into a vector of T. T must provide
+ *
+ *     void decodeField(const std::string &section, const std::string &key, FieldValue &value);
+ */
+template <class T>
+class GitTools::StreamDecoder: public GitTools::PageParser
+{
+public:
+    typedef typename T::Pointer Pointer;
+    typedef typename T::Vector Vector;
+
+    /** Called on each new object before its fields are decoded. */
+    typedef std::function<void(T &)> Prepare;
+
+    StreamDecoder(Vector &vec, const Prepare &prepare = nullptr): vec(vec), prepare(prepare) {}
+
+protected:
+    void beginElement() override {
+        current = std::make_shared<T>();
+        if (prepare != nullptr) {
+            prepare(*current);
+        }
+    }
+
+    void field(const std::string &section, const std::string &key, FieldValue &value) override {
+        current->decodeField(section, key, value);
+    }
+
+    void endElement() override {
+        vec.push_back(current);
+        current = nullptr;
+    }
+
+    Vector &vec;
+    Prepare prepare;
+    Pointer current = nullptr;
+};
+
+/**
+ * Like StreamDecoder, but decodes into a PackedVector, so there's no allocation per object.
+ */
+template <class T>
+class GitTools::PackedDecoder: public GitTools::PageParser
+{
+public:
+    typedef typename StreamDecoder<T>::Prepare Prepare;
+
+    PackedDecoder(PackedVector<T> &vec, const Prepare &prepare = nullptr): vec(vec), prepare(prepare) {}
+
+protected:
+    void beginElement() override {
+        current = &vec.add();
+        if (prepare != nullptr) {
+            prepare(*current);
+        }
+    }
+
+    void field(const std::string &section, const std::string &key, FieldValue &value) override {
+        current->decodeField(section, key, value);
+    }
+
+    void endElement() override {
+        current = nullptr;
+    }
+
+    PackedVector<T> &vec;
+    Prepare prepare;
+    T * current = nullptr;
+};
@@ -1,7 +1,31 @@
+#include <unordered_map>
+
 #include "Team.h"
 
 using namespace GitTools;
 
+namespace {
+    /** How the stream decoder sets one top-level field. */
+    typedef void (*FieldSetter)(Team &, FieldValue &);
+
+    const std::unordered_map<std::string, FieldSetter> & fieldSetters() {
+        static const std::unordered_map<std::string, FieldSetter> setters {
+            { "node_id", [](Team &t, FieldValue &v) { t.node_id = v.takeString(); } },
+            { "url", [](Team &t, FieldValue &v) { t.url = v.takeString(); } },
+            { "html_url", [](Team &t, FieldValue &v) { t.html_url = v.takeString(); } },
+            { "name", [](Team &t, FieldValue &v) { t.name = v.takeString(); } },
+            { "slug", [](Team &t, FieldValue &v) { t.slug = v.takeString(); } },
+            { "description", [](Team &t, FieldValue &v) { t.description = v.takeString(); } },
+            { "privacy", [](Team &t, FieldValue &v) { t.privacy = v.takeString(); } },
+            { "permission", [](Team &t, FieldValue &v) { t.permission = v.takeString(); } },
+            { "members_url", [](Team &t, FieldValue &v) { t.members_url = v.takeString(); } },
+            { "repositories_url", [](Team &t, FieldValue &v) { t.repositories_url = v.takeString(); } },
+            { "id", [](Team &t, FieldValue &v) { t.id = v.asInt(); } },
+        };
+        return setters;
+    }
+}
+
 /**
  *
  */
@@ -42,3 +66,18 @@ JSON Team::toJSON() const {
 
     return json;
 }
+
+/**
+ * Take one field from the stream decoder. Parent is an object, not a string, so like
+ * fromJSON we leave it empty.
+ */
+void Team::decodeField(const std::string &section, const std::string &key, FieldValue &value) {
+    if (!section.empty()) {
+        return;
+    }
+
+    auto it = fieldSetters().find(key);
+    if (it != fieldSetters().end()) {
+        it->second(*this, value);
+    }
+}
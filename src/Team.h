@@ -4,6 +4,8 @@
 
 #include <showlib/JSONSerializable.h>
 
+#include "StreamDecoder.h"
+
 namespace GitTools {
     class Team;
 }
@@ -13,10 +15,14 @@ class GitTools::Team: public ShowLib::JSONSerializable
 public:
     typedef std::shared_ptr<Team> Pointer;
     typedef ShowLib::JSONSerializableVector<Team> Vector;
+    typedef PackedVector<Team> Packed;
 
     void fromJSON(const JSON &) override;
     JSON toJSON() const override;
 
+    /** Used by StreamDecoder. */
+    void decodeField(const std::string &section, const std::string &key, FieldValue &value);
+
     std::string node_id;
     std::string url;
     std::string html_url;
@@ -28,7 +34,7 @@ public:
     std::string members_url;
     std::string repositories_url;
     std::string parent;
-    int id;
+    int id = 0;
 
 };
 
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include <unistd.h>
+
+#include <showlib/CommonUsing.h>
+
+#include "Tracer.h"
+
+using namespace GitTools;
+
+namespace {
+    long long microseconds(Tracer::Clock::duration duration) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    }
+}
+
+//======================================================================
+// Spans.
+//======================================================================
+
+Tracer::Span::Span(Tracer *t, const std::string &n, const std::string &c)
+    : tracer(t), name(n), category(c), started(Clock::now()), args(JSON::object())
+{
+}
+
+Tracer::Span::Span(Span &&other)
+    : tracer(other.tracer), name(std::move(other.name)), category(std::move(other.category)),
+      started(other.started), args(std::move(other.args))
+{
+    other.tracer = nullptr;
+}
+
+Tracer::Span & Tracer::Span::operator=(Span &&other) {
+    if (this != &other) {
+        end();
+        tracer = other.tracer;
+        name = std::move(other.name);
+        category = std::move(other.category);
+        started = other.started;
+        args = std::move(other.args);
+        other.tracer = nullptr;
+    }
+    return *this;
+}
+
+Tracer::Span::~Span() {
+    end();
+}
+
+Tracer::Span & Tracer::Span::arg(const std::string &key, const JSON &value) {
+    if (tracer != nullptr) {
+        args[key] = value;
+    }
+    return *this;
+}
+
+void Tracer::Span::end() {
+    if (tracer != nullptr) {
+        tracer->complete(name, category, started, Clock::now(), args);
+        tracer = nullptr;
+    }
+}
+
+//======================================================================
+// The tracer.
+//======================================================================
+
+Tracer::Tracer()
+    : origin(Clock::now())
+{
+}
+
+/**
+ * Start recording. Times in the trace are from here, and this thread is "main".
+ */
+void Tracer::enable() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!enabled) {
+        origin = Clock::now();
+        mainThread = std::this_thread::get_id();
+        enabled = true;
+    }
+}
+
+Tracer::Span Tracer::span(const std::string &name, const std::string &category) {
+    return enabled ? Span(this, name, category) : Span();
+}
+
+void Tracer::complete(const std::string &name, const std::string &category, Clock::time_point started, Clock::time_point ended, const JSON &args) {
+    if (!enabled) {
+        return;
+    }
+
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.args = args;
+    record(std::move(event), started, ended);
+}
+
+void Tracer::completeAsync(const std::string &name, const std::string &category, Clock::time_point started, Clock::time_point ended, const JSON &args) {
+    if (!enabled) {
+        return;
+    }
+
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.args = args;
+    event.asyncId = -1;
+    record(std::move(event), started, ended);
+}
+
+void Tracer::record(Event &&event, Clock::time_point started, Clock::time_point ended) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (event.asyncId != 0) {
+        event.asyncId = ++lastAsyncId;
+    }
+    event.threadId = threadId();
+    event.start = microseconds(started - origin);
+    event.duration = std::max(microseconds(ended - started), 0LL);
+    events.push_back(std::move(event));
+}
+
+/**
+ * Small numbers are easier to read in the viewer than thread::id hashes. Called with
+ * the mutex held.
+ */
+int Tracer::threadId() {
+    std::thread::id id = std::this_thread::get_id();
+    auto it = std::find(threads.begin(), threads.end(), id);
+    if (it == threads.end()) {
+        it = threads.insert(threads.end(), id);
+    }
+    return static_cast<int>(it - threads.begin()) + 1;
+}
+
+size_t Tracer::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return events.size();
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.clear();
+}
+
+/**
+ * Complete ("X") events, and begin and end ("b", "e") pairs for the async ones, sorted
+ * by time, with metadata events naming the process and each thread.
+ */
+JSON Tracer::toJSON() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    long pid = static_cast<long>(getpid());
+
+    JSON traceEvents = JSON::array();
+
+    JSON process = JSON::object();
+    process["ph"] = "M";
+    process["name"] = "process_name";
+    process["pid"] = pid;
+    process["args"] = { { "name", "GitTool" } };
+    traceEvents.push_back(process);
+
+    for (size_t index = 0; index < threads.size(); ++index) {
+        JSON thread = JSON::object();
+        thread["ph"] = "M";
+        thread["name"] = "thread_name";
+        thread["pid"] = pid;
+        thread["tid"] = index + 1;
+        thread["args"] = { { "name", threads[index] == mainThread ? string{"main"} : "worker " + std::to_string(index + 1) } };
+        traceEvents.push_back(thread);
+    }
+
+    // Each event with the time it sorts by.
+    std::vector<std::pair<long long, JSON>> timed;
+    timed.reserve(events.size());
+
+    for (const Event &event: events) {
+        JSON json = JSON::object();
+        json["name"] = event.name;
+        json["cat"] = event.category;
+        json["ts"] = event.start;
+        json["pid"] = pid;
+        json["tid"] = event.threadId;
+        if (!event.args.empty()) {
+            json["args"] = event.args;
+        }
+
+        if (event.asyncId == 0) {
+            json["ph"] = "X";
+            json["dur"] = event.duration;
+            timed.emplace_back(event.start, std::move(json));
+            continue;
+        }
+
+        json["ph"] = "b";
+        json["id"] = event.asyncId;
+        JSON end = JSON::object();
+        end["ph"] = "e";
+        end["name"] = event.name;
+        end["cat"] = event.category;
+        end["id"] = event.asyncId;
+        end["ts"] = event.start + event.duration;
+        end["pid"] = pid;
+        end["tid"] = event.threadId;
+        timed.emplace_back(event.start, std::move(json));
+        timed.emplace_back(event.start + event.duration, std::move(end));
+    }
+    std::stable_sort(timed.begin(), timed.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    for (auto & [time, json]: timed) {
+        traceEvents.push_back(std::move(json));
+    }
+
+    JSON rv = JSON::object();
+    rv["traceEvents"] = traceEvents;
+    rv["displayTimeUnit"] = "ms";
+    return rv;
+}
+
+/**
+ * Write to disk, by way of a temporary file.
+ */
+bool Tracer::save(const std::string &path) const {
+    string tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream output(tmpPath, std::ios::trunc);
+        if (!output) {
+            return false;
+        }
+        output << toJSON().dump() << "\n";
+        if (!output) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmpPath, path, error);
+    if (error) {
+        std::filesystem::remove(tmpPath, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <showlib/JSONSerializable.h>
+
+namespace GitTools {
+    class Tracer;
+}
+
+/**
+ * Records what each thread was doing and when, as a Chrome trace-event file you can
+ * open in chrome://tracing or https://ui.perfetto.dev. Server adds a span for every
+ * HTTP request, every page it hands to a listing's decoder, every bulk-work item and
+ * every wait for the rate limiter. Each span has the thread it ran on and, where
+ * there is one, the endpoint (as RequestStats names them).
+ *
+ *     server.getTracer().enable();
+ *     server.getRepositories(orgName);
+ *     server.getTracer().save("trace.json");
+ *
+ * Tracing is off until enable() is called, and spans cost next to nothing until then.
+ * All methods may be called from several threads.
+ */
+class GitTools::Tracer
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * One span, recorded when it goes out of scope or end() is called. A span from a
+     * disabled tracer does nothing.
+     */
+    class Span {
+    public:
+        Span() = default;
+        Span(Tracer *tracer, const std::string &name, const std::string &category);
+        Span(Span &&other);
+        Span & operator=(Span &&other);
+        ~Span();
+
+        Span(const Span &) = delete;
+        Span & operator=(const Span &) = delete;
+
+        bool isActive() const { return tracer != nullptr; }
+
+        /** Shown when the span is selected. */
+        Span & arg(const std::string &key, const JSON &value);
+
+        void end();
+
+    protected:
+        Tracer * tracer = nullptr;
+        std::string name;
+        std::string category;
+        Clock::time_point started;
+        JSON args;
+    };
+
+    Tracer();
+
+    void enable();
+    void disable() { enabled = false; }
+    bool isEnabled() const { return enabled; }
+
+    /** A span that starts now. */
+    Span span(const std::string &name, const std::string &category);
+
+    /** A span we timed ourselves. */
+    void complete(const std::string &name, const std::string &category, Clock::time_point started, Clock::time_point ended, const JSON &args);
+
+    /**
+     * The same for work that overlaps other work on its thread, such as the requests an
+     * IOExecutor runs at once. These get a row of their own in the viewer.
+     */
+    void completeAsync(const std::string &name, const std::string &category, Clock::time_point started, Clock::time_point ended, const JSON &args);
+
+    size_t size() const;
+    void clear();
+
+    /** The whole trace, {"traceEvents": [...]}. */
+    JSON toJSON() const;
+
+    bool save(const std::string &path) const;
+
+protected:
+    class Event {
+    public:
+        std::string name;
+        std::string category;
+        int threadId = 0;
+        long long start = 0;
+        long long duration = 0;
+        JSON args;
+
+        /** For completeAsync, which pairs a begin and end event by id. Otherwise 0. */
+        long long asyncId = 0;
+    };
+
+    void record(Event &&event, Clock::time_point started, Clock::time_point ended);
+
+    int threadId();
+
+    std::atomic<bool> enabled { false };
+    Clock::time_point origin;
+    std::thread::id mainThread;
+
+    mutable std::mutex mutex;
+    std::vector<Event> events;
+    std::vector<std::thread::id> threads;
+    long long lastAsyncId = 0;
+};
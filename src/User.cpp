@@ -1,7 +1,69 @@
+#include <unordered_map>
+
 #include "User.h"
 
 using namespace GitTools;
 
+namespace {
+    /** How the stream decoder sets one field. */
+    typedef void (*FieldSetter)(User &, FieldValue &);
+
+    const std::unordered_map<std::string, FieldSetter> & fieldSetters() {
+        static const std::unordered_map<std::string, FieldSetter> setters {
+            { "avatar_url", [](User &u, FieldValue &v) { u.avatar_url = v.takeString(); } },
+            { "bio", [](User &u, FieldValue &v) { u.bio = v.takeString(); } },
+            { "blog", [](User &u, FieldValue &v) { u.blog = v.takeString(); } },
+            { "company", [](User &u, FieldValue &v) { u.company = v.takeString(); } },
+            { "email", [](User &u, FieldValue &v) { u.email = v.takeString(); } },
+            { "events_url", [](User &u, FieldValue &v) { u.events_url = v.takeString(); } },
+            { "followers_url", [](User &u, FieldValue &v) { u.followers_url = v.takeString(); } },
+            { "following_url", [](User &u, FieldValue &v) { u.following_url = v.takeString(); } },
+            { "gists_url", [](User &u, FieldValue &v) { u.gists_url = v.takeString(); } },
+            { "gravatar_id", [](User &u, FieldValue &v) { u.gravatar_id = v.takeString(); } },
+            { "html_url", [](User &u, FieldValue &v) { u.html_url = v.takeString(); } },
+            { "location", [](User &u, FieldValue &v) { u.location = v.takeString(); } },
+            { "login", [](User &u, FieldValue &v) { u.login = v.takeString(); } },
+            { "name", [](User &u, FieldValue &v) { u.name = v.takeString(); } },
+            { "node_id", [](User &u, FieldValue &v) { u.node_id = v.takeString(); } },
+            { "organizations_url", [](User &u, FieldValue &v) { u.organizations_url = v.takeString(); } },
+            { "received_events_url", [](User &u, FieldValue &v) { u.received_events_url = v.takeString(); } },
+            { "repos_url", [](User &u, FieldValue &v) { u.repos_url = v.takeString(); } },
+            { "starred_url", [](User &u, FieldValue &v) { u.starred_url = v.takeString(); } },
+            { "subscriptions_url", [](User &u, FieldValue &v) { u.subscriptions_url = v.takeString(); } },
+            { "type", [](User &u, FieldValue &v) { u.type = v.takeString(); } },
+            { "twitter_username", [](User &u, FieldValue &v) { u.twitter_username = v.takeString(); } },
+            { "url", [](User &u, FieldValue &v) { u.url = v.takeString(); } },
+            { "created_at", [](User &u, FieldValue &v) { u.created_at = v.takeString(); } },
+            { "updated_at", [](User &u, FieldValue &v) { u.updated_at = v.takeString(); } },
+            { "collaborators", [](User &u, FieldValue &v) { u.collaborators = v.asInt(); } },
+            { "disk_usage", [](User &u, FieldValue &v) { u.disk_usage = v.asInt(); } },
+            { "followers", [](User &u, FieldValue &v) { u.followers = v.asInt(); } },
+            { "following", [](User &u, FieldValue &v) { u.following = v.asInt(); } },
+            { "id", [](User &u, FieldValue &v) { u.id = v.asInt(); } },
+            { "owned_private_repos", [](User &u, FieldValue &v) { u.owned_private_repos = v.asInt(); } },
+            { "public_repos", [](User &u, FieldValue &v) { u.public_repos = v.asInt(); } },
+            { "public_gists", [](User &u, FieldValue &v) { u.public_gists = v.asInt(); } },
+            { "private_gists", [](User &u, FieldValue &v) { u.private_gists = v.asInt(); } },
+            { "total_private_repos", [](User &u, FieldValue &v) { u.total_private_repos = v.asInt(); } },
+            { "hireable", [](User &u, FieldValue &v) { u.hireable = v.asBool(); } },
+            { "site_admin", [](User &u, FieldValue &v) { u.site_admin = v.asBool(); } },
+            { "two_factor_authentication", [](User &u, FieldValue &v) { u.two_factor_authentication = v.asBool(); } },
+        };
+        return setters;
+    }
+
+    /** The fields inside "plan". */
+    const std::unordered_map<std::string, FieldSetter> & planSetters() {
+        static const std::unordered_map<std::string, FieldSetter> setters {
+            { "name", [](User &u, FieldValue &v) { u.plan_name = v.takeString(); } },
+            { "space", [](User &u, FieldValue &v) { u.plan_space = v.asInt(); } },
+            { "private_repos", [](User &u, FieldValue &v) { u.plan_private_repos = v.asInt(); } },
+            { "collaborators", [](User &u, FieldValue &v) { u.plan_collaborators = v.asInt(); } },
+        };
+        return setters;
+    }
+}
+
 void User::fromJSON(const JSON &json) {
     avatar_url = stringValue(json, "avatar_url");
     bio = stringValue(json, "bio");
@@ -33,7 +95,7 @@ void User::fromJSON(const JSON &json) {
     disk_usage = intValue(json, "disk_usage");
     followers = intValue(json, "followers");
     following = intValue(json, "following");
-    id = intValue(json, "idl");
+    id = intValue(json, "id");
     owned_private_repos = intValue(json, "owned_private_repos");
     public_repos = intValue(json, "public_repos");
     public_gists = intValue(json, "public_gists");
@@ -53,6 +115,27 @@ void User::fromJSON(const JSON &json) {
 
 }
 
+/**
+ * Take one field from the stream decoder.
+ */
+void User::decodeField(const std::string &section, const std::string &key, FieldValue &value) {
+    const std::unordered_map<std::string, FieldSetter> *setters = nullptr;
+    if (section.empty()) {
+        setters = &fieldSetters();
+    }
+    else if (section == "plan") {
+        setters = &planSetters();
+    }
+    else {
+        return;
+    }
+
+    auto it = setters->find(key);
+    if (it != setters->end()) {
+        it->second(*this, value);
+    }
+}
+
 JSON User::toJSON() const {
     JSON json = JSON::object();
 
@@ -62,18 +145,18 @@ JSON User::toJSON() const {
     json["company"] = company;
     json["email"] = email;
     json["events_url"] = events_url;
-    json["followers_ur"] = followers_url;
+    json["followers_url"] = followers_url;
     json["following_url"] = following_url;
     json["gists_url"] = gists_url;
     json["gravatar_id"] = gravatar_id;
     json["html_url"] = html_url;
     json["location"] = location;
     json["login"] = login;
-    json["namo"] = name;
+    json["name"] = name;
     json["node_id"] = node_id;
     json["organizations_url"] = organizations_url;
     json["received_events_url"] = received_events_url;
-    json["repos_urlo"] = repos_url;
+    json["repos_url"] = repos_url;
     json["starred_url"] = starred_url;
     json["subscriptions_url"] = subscriptions_url;
     json["type"] = type;
@@ -103,6 +186,7 @@ JSON User::toJSON() const {
     planJSON["space"] = plan_space;
     planJSON["private_repos"] = plan_private_repos;
     planJSON["collaborators"] = plan_collaborators;
+    json["plan"] = planJSON;
 
     return json;
 }
@@ -2,6 +2,9 @@
 
 #include <showlib/JSONSerializable.h>
 
+#include "NameIndex.h"
+#include "StreamDecoder.h"
+
 namespace GitTools {
     class User;
 }
@@ -11,10 +14,18 @@ class GitTools::User: public ShowLib::JSONSerializable
 public:
     typedef std::shared_ptr<User> Pointer;
     typedef ShowLib::JSONSerializableVector<User> Vector;
+    typedef PackedVector<User> Packed;
+    typedef NameIndex<User> Index;
 
     void fromJSON(const JSON &);
     JSON toJSON() const;
 
+    /** Used by StreamDecoder. */
+    void decodeField(const std::string &section, const std::string &key, FieldValue &value);
+
+    /** Key function for Index. */
+    static const std::string & indexByLogin(const User &user) { return user.login; }
+
     std::string avatar_url;
     std::string bio;
     std::string blog;
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "WorkerPool.h"
+
+using namespace GitTools;
+
+WorkerPool::WorkerPool(int workers)
+    : maxWorkers(workers > 0 ? workers : 1)
+{
+}
+
+/**
+ * Call work(0) through work(itemCount - 1), using at most maxWorkers threads.
+ * If any item throws, the remaining unstarted items are skipped and the first
+ * exception is rethrown once all threads have finished.
+ */
+void WorkerPool::run(size_t itemCount, const WorkFunction &work) const {
+    if (itemCount == 0) {
+        return;
+    }
+
+    size_t threadCount = std::min(itemCount, static_cast<size_t>(maxWorkers));
+    if (threadCount == 1) {
+        for (size_t index = 0; index < itemCount; ++index) {
+            work(index);
+        }
+        return;
+    }
+
+    std::atomic<size_t> nextIndex { 0 };
+    std::atomic<bool> failed { false };
+    std::exception_ptr firstError = nullptr;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        while (!failed) {
+            size_t index = nextIndex++;
+            if (index >= itemCount) {
+                break;
+            }
+            try {
+                work(index);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (firstError == nullptr) {
+                    firstError = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (size_t count = 0; count < threadCount; ++count) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    if (firstError != nullptr) {
+        std::rethrow_exception(firstError);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace GitTools {
+    class WorkerPool;
+}
+
+/**
+ * Runs a known number of independent work items across a bounded number of threads.
+ * Items are handed out in index order, so callers that store results by index
+ * get them back in a predictable layout regardless of completion order.
+ */
+class GitTools::WorkerPool
+{
+public:
+    typedef std::function<void(size_t index)> WorkFunction;
+
+    WorkerPool(int maxWorkers = 4);
+
+    int getMaxWorkers() const { return maxWorkers; }
+    WorkerPool & setMaxWorkers(int value) { maxWorkers = value > 0 ? value : 1; return *this; }
+
+    void run(size_t itemCount, const WorkFunction &work) const;
+
+protected:
+    int maxWorkers;
+};
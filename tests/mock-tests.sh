@@ -0,0 +1,156 @@
+#!/bin/bash
+#======================================================================
+# Runs GitTool against MockGitHub and checks what it does: paging, a page
+# that fails, --where, and plans saved with --plan and carried out with
+# --apply. make test runs this after building both; to run it by hand:
+#
+#     tests/mock-tests.sh [bindir]
+#
+# Each check prints ok or FAILED, and the exit status is the number that
+# failed. MOCK_PORT picks the port (default 18080).
+#======================================================================
+
+BIN=${1:-bin}
+PORT=${MOCK_PORT:-18080}
+WORK=$(mktemp -d)
+MOCK_PID=
+FAILURES=0
+
+stopMock() {
+    if [ -n "${MOCK_PID}" ]; then
+        kill ${MOCK_PID} 2>/dev/null
+        wait ${MOCK_PID} 2>/dev/null
+        MOCK_PID=
+    fi
+}
+
+cleanUp() {
+    stopMock
+    rm -rf "${WORK}"
+}
+trap cleanUp EXIT
+
+# Start a fresh mock with these options and wait until it answers.
+startMock() {
+    stopMock
+    if (echo > /dev/tcp/127.0.0.1/${PORT}) 2>/dev/null; then
+        echo "Something is already listening on port ${PORT}; set MOCK_PORT"
+        exit 1
+    fi
+    "${BIN}/MockGitHub" --port ${PORT} "$@" >/dev/null 2>&1 &
+    MOCK_PID=$!
+    for try in $(seq 50); do
+        if ! kill -0 ${MOCK_PID} 2>/dev/null; then
+            break
+        fi
+        if (echo > /dev/tcp/127.0.0.1/${PORT}) 2>/dev/null; then
+            return
+        fi
+        sleep 0.1
+    done
+    echo "MockGitHub didn't start on port ${PORT}"
+    exit 1
+}
+
+# GitTool against the mock. A run that hangs is killed after a minute (status 124).
+gitTool() {
+    GIT_HOST=http://127.0.0.1:${PORT} timeout 60 "${BIN}/GitTool" "$@" 2>"${WORK}/stderr"
+}
+
+# check "what" expected actual
+check() {
+    if [ "$2" == "$3" ]; then
+        echo "ok      $1"
+    else
+        echo "FAILED  $1: expected '$2', got '$3'"
+        FAILURES=$((FAILURES + 1))
+    fi
+}
+
+# How many different repos a listing of org1 returns, given more GitTool options.
+repoCount() {
+    gitTool --org org1 --repos --format csv --fields name "$@" | tail -n +2 | sort -u | wc -l | tr -d ' '
+}
+
+# How many steps a saved plan has. Plans are written one key per line.
+stepCount() {
+    grep -c '"action"' "$1"
+}
+
+#----------------------------------------------------------------------
+# Paging. With a Link rel="last" we fetch the pages we know about; without
+# one we walk, or probe, until an empty page. Either way, every repo once,
+# including when the last page is exactly full.
+#----------------------------------------------------------------------
+for linkOption in "" --no-last-link; do
+    for repos in 250 300; do
+        startMock --repos ${repos} ${linkOption}
+        for workers in 1 4; do
+            check "${repos} repos ${linkOption:-with rel=last}, --workers ${workers}" ${repos} $(repoCount --workers ${workers})
+        done
+    done
+done
+
+#----------------------------------------------------------------------
+# A page that fails part way through a listing fails the whole listing,
+# one page at a time or with several page workers, and doesn't hang.
+#----------------------------------------------------------------------
+startMock --repos 2000 --fail-page 5 --error-rate 5
+for workers in 1 4 8; do
+    gitTool --org org1 --repos --workers ${workers} >/dev/null
+    check "a failed page fails the listing with --workers ${workers}" 1 $?
+done
+
+#----------------------------------------------------------------------
+# --where. The mock's repos are made up from their numbers, so we know how
+# many of the 250 each expression should match.
+#----------------------------------------------------------------------
+startMock --repos 250
+check "--where archived=true" 25 $(repoCount --where "archived=true")
+check "--where with and" 42 $(repoCount --where "archived=false and language=Go")
+check "--where with not, or and parentheses" 94 $(repoCount --where "not (private=true) or fork=true")
+check "--where on a date" 119 $(repoCount --where "pushed_at>=2023-11-10")
+check "--where with a quoted value" 10 $(repoCount --where "name ~ 'repo-0001'")
+
+for bad in "archived=maybe" "nosuch=1" "(archived=true" "pushed_at<2024-13-01" "forks_count~3" "id=abc" "archived=true and"; do
+    gitTool --org org1 --repos --where "${bad}" >/dev/null
+    check "--where \"${bad}\" is refused" 2 $?
+done
+
+#----------------------------------------------------------------------
+# Plans. --plan writes the changes without making them, --apply makes
+# them, and a plan made afterwards has nothing left to do. Every default
+# branch gets a step: the even repos' lose enforce_admins, and the odd
+# repos' are unprotected, which always takes a PUT.
+#----------------------------------------------------------------------
+startMock --repos 250
+PLAN="${WORK}/plan.json"
+
+gitTool --org org1 --add-branch-protection '*' --no-enforce-admins --plan "${PLAN}" >/dev/null
+check "--plan exits 0" 0 $?
+check "--plan writes the steps" 250 $(stepCount "${PLAN}")
+
+gitTool --org org1 --add-branch-protection '*' --no-enforce-admins --plan "${WORK}/again.json" >/dev/null
+check "--plan makes no changes" 250 $(stepCount "${WORK}/again.json")
+
+gitTool --apply "${PLAN}" >"${WORK}/applied"
+check "--apply exits 0" 0 $?
+check "--apply makes every change" "Applied 250 of 250" "$(grep -o 'Applied [0-9]* of [0-9]*' "${WORK}/applied")"
+
+gitTool --org org1 --add-branch-protection '*' --no-enforce-admins --plan "${WORK}/after.json" >/dev/null
+check "a plan after --apply is empty" 0 $(stepCount "${WORK}/after.json")
+
+gitTool --org org1 --delete-branch-protection '*' --plan "${WORK}/delete.json" >/dev/null
+gitTool --apply "${WORK}/delete.json" >/dev/null
+check "a delete plan applies" 0 $?
+gitTool --apply "${WORK}/delete.json" >/dev/null
+check "a delete plan applies again, as the branches are already unprotected" 0 $?
+
+gitTool --apply "${WORK}/missing.json" >/dev/null
+check "--apply of a missing file exits 1" 1 $?
+
+echo '{"org": "org1", "steps": [{"action": "rename_repo", "repo": "repo-00000"}]}' > "${WORK}/unknown.json"
+gitTool --apply "${WORK}/unknown.json" >/dev/null
+check "--apply of an unknown action exits 1" 1 $?
+
+exit ${FAILURES}